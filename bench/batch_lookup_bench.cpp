@@ -0,0 +1,103 @@
+#include <swar/batch_lookup.hpp>
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace swar;
+
+// Batched (set, value) lookups against 512 MiB of sets, well beyond the
+// last-level cache, in random order. Sets are full PackedSets in a
+// line-aligned array, reached through an array of pointers to random
+// sets:
+//   OneLine  PackedSet<11, 40>: 8 words, one line per set, 8M sets;
+//   TwoLine  PackedSet<11, 80>: 16 words, two lines per set, 4M sets.
+// Half the needles are present; in TwoLine sets half of those sit in the
+// first line. Iterations walk a kLookups-long stream of pairs, one batch
+// of kBatch pairs each, so the sets touched between two visits to a
+// batch far exceed the cache:
+//   Naive     sets[i]->contains(values[i]) in a plain loop;
+//   Prefetch  contains_batch (group prefetch);
+//   Amac      contains_batch_amac.
+
+static constexpr std::size_t kSetBytes = std::size_t(512) << 20;
+static constexpr std::size_t kLookups = std::size_t(1) << 23;
+static constexpr std::size_t kBatch = 4096;
+
+/// Value j of set s: distinct for j < 512, all in [1, 1023].
+static uint64_t set_value(std::size_t s, std::size_t j) {
+    return (s * 0x9e3779b1u + j) % 1023 + 1;
+}
+
+template <class Set> struct Workload {
+    std::vector<Set, CacheLineAllocator<Set>> sets;
+    std::vector<const Set *> ptrs; // one per lookup, over all batches
+    std::vector<uint64_t> values;
+
+    Workload() : sets(kSetBytes / sizeof(Set)) {
+        for (std::size_t s = 0; s < sets.size(); ++s)
+            for (std::size_t j = 0; j < Set::capacity; ++j)
+                sets[s].insert(set_value(s, j));
+        std::mt19937_64 rng(42);
+        for (std::size_t i = 0; i < kLookups; ++i) {
+            std::size_t s = rng() % sets.size();
+            std::size_t j = rng() % Set::capacity;
+            if (i & 1)
+                j += Set::capacity; // absent
+            ptrs.push_back(&sets[s]);
+            values.push_back(set_value(s, j));
+        }
+    }
+
+    static const Workload &get() {
+        static const Workload w;
+        return w;
+    }
+};
+
+enum class Schedule { naive, prefetch, amac };
+
+template <class Set, Schedule S>
+static void BM_BatchLookup(benchmark::State &state) {
+    const auto &w = Workload<Set>::get();
+    std::unique_ptr<bool[]> out(new bool[kBatch]);
+    const std::size_t batches = w.ptrs.size() / kBatch;
+    std::size_t b = 0, hits = 0;
+    for (auto _ : state) {
+        const Set *const *sets = w.ptrs.data() + b * kBatch;
+        const uint64_t *values = w.values.data() + b * kBatch;
+        if constexpr (S == Schedule::naive) {
+            for (std::size_t i = 0; i < kBatch; ++i)
+                out[i] = sets[i]->contains(values[i]);
+        } else if constexpr (S == Schedule::prefetch) {
+            contains_batch(sets, values, kBatch, out.get());
+        } else {
+            contains_batch_amac(sets, values, kBatch, out.get());
+        }
+        hits += out[kBatch - 1];
+        benchmark::ClobberMemory();
+        b = (b + 1) % batches;
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations() * kBatch);
+    state.counters["set_bytes"] = sizeof(Set);
+}
+
+using OneLine = PackedSet<11, 40>;
+using TwoLine = PackedSet<11, 80>;
+
+static_assert(sizeof(OneLine) == 64 && sizeof(TwoLine) == 128,
+              "sets must fill whole lines");
+
+#define REGISTER_SCHEDULES(Set)                                                \
+    BENCHMARK_TEMPLATE(BM_BatchLookup, Set, Schedule::naive)                   \
+        ->Name("BM_BatchLookup_Naive/" #Set);                                  \
+    BENCHMARK_TEMPLATE(BM_BatchLookup, Set, Schedule::prefetch)                \
+        ->Name("BM_BatchLookup_Prefetch/" #Set);                               \
+    BENCHMARK_TEMPLATE(BM_BatchLookup, Set, Schedule::amac)                    \
+        ->Name("BM_BatchLookup_Amac/" #Set)
+
+REGISTER_SCHEDULES(OneLine);
+REGISTER_SCHEDULES(TwoLine);
@@ -0,0 +1,77 @@
+#include <swar/bulk_build.hpp>
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace swar;
+
+// End-to-end rebuild: kPairs random (entity, value) pairs into one
+// PackedSetArena set per entity, about 16 pairs per entity with values
+// drawn from [1, 1023], so a few percent are duplicates. Items are input
+// pairs, so items_per_second is pairs per second.
+//
+// BM_BulkBuild's argument is the builder's thread count, from 1 to every
+// core. BM_InsertLoop is the single-threaded per-pair insert it replaces.
+
+static constexpr std::size_t kPairs = std::size_t(1) << 22;
+static constexpr std::size_t kEntities = kPairs / 16;
+
+// 32 values in 7 words, strided to 8: one cache line per set.
+using Arena = PackedSetArena<11, 32, true>;
+
+static const std::vector<EntityValue> &input_pairs() {
+    static const std::vector<EntityValue> pairs = [] {
+        std::vector<EntityValue> p(kPairs);
+        std::mt19937 rng(42);
+        for (auto &x : p) {
+            x.entity = static_cast<uint32_t>(rng() % kEntities);
+            x.value = static_cast<uint32_t>(rng() % 1023 + 1);
+        }
+        return p;
+    }();
+    return pairs;
+}
+
+/// Thread counts 1, 2, 4, ... up to and including every core.
+static void up_to_all_cores(benchmark::internal::Benchmark *b) {
+    int cores = std::max(1, static_cast<int>(
+                                std::thread::hardware_concurrency()));
+    for (int t = 1; t < cores; t *= 2)
+        b->Arg(t);
+    b->Arg(cores);
+}
+
+static void BM_InsertLoop(benchmark::State &state) {
+    const auto &pairs = input_pairs();
+    Arena a;
+    for (auto _ : state) {
+        a.resize(0);
+        a.resize(kEntities);
+        for (const auto &p : pairs)
+            benchmark::DoNotOptimize(a.insert(p.entity, p.value));
+    }
+    state.SetItemsProcessed(state.iterations() * kPairs);
+}
+
+static void BM_BulkBuild(benchmark::State &state) {
+    const auto &pairs = input_pairs();
+    const auto threads = static_cast<unsigned>(state.range(0));
+    Arena a;
+    for (auto _ : state) {
+        a.resize(0);
+        auto stats =
+            bulk_build(a, pairs.data(), pairs.size(), kEntities, threads);
+        benchmark::DoNotOptimize(stats);
+    }
+    state.SetItemsProcessed(state.iterations() * kPairs);
+}
+
+BENCHMARK(BM_InsertLoop)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BulkBuild)
+    ->Apply(up_to_all_cores)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
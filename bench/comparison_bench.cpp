@@ -1,10 +1,16 @@
 #include <swar/bucketed_set.hpp>
+#include <swar/counted_packed_set.hpp>
+#include <swar/packed_hash_set.hpp>
 #include <swar/packed_set.hpp>
+#include <swar/packed_set_arena.hpp>
 #include <swar/packed_word.hpp>
+#include <swar/sorted_packed_set.hpp>
 
 #include <algorithm>
 #include <array>
 #include <benchmark/benchmark.h>
+#include <iterator>
+#include <memory>
 #include <random>
 #include <set>
 #include <unordered_set>
@@ -16,14 +22,16 @@ using namespace swar;
 static constexpr unsigned N = 11;
 using PW = PackedWord<N>;
 
-// Fixed set size for all benchmarks.
-//static constexpr std::size_t kSize = 10;
-static constexpr std::size_t kSize = 5;
+// The core suite (insert / contains / miss / erase / memory) is a size
+// sweep: every benchmark is a template on Size, registered for
+// 1, 2, 4, ..., 512. 1024 is out of reach because N=11 only has 1023
+// usable values.
 
-// Store N and kSize in benchmark counters so visualization can read them.
+// Store N and Size in benchmark counters so visualization can read them.
+// Expects a template parameter named Size in scope.
 #define SET_COUNTERS(state)                                                    \
     state.counters["N"] = N;                                                   \
-    state.counters["size"] = kSize;
+    state.counters["size"] = Size;
 
 // ---------- Helpers ----------
 
@@ -41,58 +49,77 @@ static std::vector<uint16_t> make_values(std::size_t count, uint64_t seed = 42)
     return out;
 }
 
-static const auto kVals = make_values(kSize);
-static const auto kValsMiss = make_values(kSize, 99);
+/// Size distinct values stored by the hit / erase / insert benchmarks.
+template <std::size_t Size> static const std::vector<uint16_t> &hit_values() {
+    static const auto vals = make_values(Size);
+    return vals;
+}
+
+/// Size distinct values stored by the miss benchmarks.
+template <std::size_t Size> static const std::vector<uint16_t> &miss_values() {
+    static const auto vals = make_values(Size, 99);
+    return vals;
+}
 
 // ============================================================
-// INSERT benchmarks — build a set of 10 elements from scratch
+// INSERT benchmarks — build a set of Size elements from scratch
 // ============================================================
 
+template <std::size_t Size>
 static void BM_Insert_PackedSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
-        PackedSet<N, kSize> s;
-        for (auto v : kVals)
+        PackedSet<N, Size> s;
+        for (auto v : vals)
             s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_BucketedSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
-        BucketedSet<kSize> s;
-        for (auto v : kVals)
+        BucketedSet<Size> s;
+        for (auto v : vals)
             s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_StdSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         std::set<uint16_t> s;
-        for (auto v : kVals)
+        for (auto v : vals)
             s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_UnorderedSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         std::unordered_set<uint16_t> s;
-        for (auto v : kVals)
+        for (auto v : vals)
             s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_Vector(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         std::vector<uint16_t> s;
-        for (auto v : kVals) {
+        for (auto v : vals) {
             if (std::find(s.begin(), s.end(), v) == s.end())
                 s.push_back(v);
         }
@@ -100,11 +127,13 @@ static void BM_Insert_Vector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_SortedVector(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         std::vector<uint16_t> s;
-        for (auto v : kVals) {
+        for (auto v : vals) {
             auto it = std::lower_bound(s.begin(), s.end(), v);
             if (it == s.end() || *it != v)
                 s.insert(it, v);
@@ -113,13 +142,15 @@ static void BM_Insert_SortedVector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Insert_Array(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
-        std::array<uint16_t, kSize> arr{};
+        std::array<uint16_t, Size> arr{};
         std::size_t count = 0;
         benchmark::ClobberMemory();
-        for (auto v : kVals) {
+        for (auto v : vals) {
             bool found = false;
             for (std::size_t i = 0; i < count; ++i) {
                 if (arr[i] == v) { found = true; break; }
@@ -136,80 +167,94 @@ static void BM_Insert_Array(benchmark::State &state) {
 // CONTAINS (hit) benchmarks — lookup a known-present value
 // ============================================================
 
+template <std::size_t Size>
 static void BM_Contains_PackedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    PackedSet<N, kSize> s;
-    for (auto v : kVals)
+    const auto &vals = hit_values<Size>();
+    PackedSet<N, Size> s;
+    for (auto v : vals)
         s.insert(v);
-    uint16_t target = kVals[kSize / 2];
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = s.contains(target);
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_BucketedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    BucketedSet<kSize> s;
-    for (auto v : kVals)
+    const auto &vals = hit_values<Size>();
+    BucketedSet<Size> s;
+    for (auto v : vals)
         s.insert(v);
-    uint16_t target = kVals[kSize / 2];
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = s.contains(target);
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_StdSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::set<uint16_t> s(kVals.begin(), kVals.end());
-    uint16_t target = kVals[kSize / 2];
+    const auto &vals = hit_values<Size>();
+    std::set<uint16_t> s(vals.begin(), vals.end());
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = s.count(target) > 0;
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_UnorderedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::unordered_set<uint16_t> s(kVals.begin(), kVals.end());
-    uint16_t target = kVals[kSize / 2];
+    const auto &vals = hit_values<Size>();
+    std::unordered_set<uint16_t> s(vals.begin(), vals.end());
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = s.count(target) > 0;
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_Vector(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::vector<uint16_t> s(kVals.begin(), kVals.end());
-    uint16_t target = kVals[kSize / 2];
+    const auto &vals = hit_values<Size>();
+    std::vector<uint16_t> s(vals.begin(), vals.end());
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = std::find(s.begin(), s.end(), target) != s.end();
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_SortedVector(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::vector<uint16_t> s(kVals.begin(), kVals.end());
+    const auto &vals = hit_values<Size>();
+    std::vector<uint16_t> s(vals.begin(), vals.end());
     std::sort(s.begin(), s.end());
-    uint16_t target = kVals[kSize / 2];
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = std::binary_search(s.begin(), s.end(), target);
         benchmark::DoNotOptimize(found);
     }
 }
 
+template <std::size_t Size>
 static void BM_Contains_Array(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::array<uint16_t, kSize> arr{};
-    for (std::size_t i = 0; i < kSize; ++i)
-        arr[i] = kVals[i];
-    uint16_t target = kVals[kSize / 2];
+    const auto &vals = hit_values<Size>();
+    std::array<uint16_t, Size> arr{};
+    for (std::size_t i = 0; i < Size; ++i)
+        arr[i] = vals[i];
+    uint16_t target = vals[Size / 2];
     for (auto _ : state) {
         bool found = false;
-        for (std::size_t i = 0; i < kSize; ++i) {
+        for (std::size_t i = 0; i < Size; ++i) {
             if (arr[i] == target) { found = true; break; }
         }
         benchmark::DoNotOptimize(found);
@@ -220,10 +265,12 @@ static void BM_Contains_Array(benchmark::State &state) {
 // CONTAINS (miss) benchmarks — lookup a value NOT in the set
 // ============================================================
 
+template <std::size_t Size>
 static void BM_ContainsMiss_PackedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    PackedSet<N, kSize> s;
-    for (auto v : kValsMiss)
+    const auto &miss = miss_values<Size>();
+    PackedSet<N, Size> s;
+    for (auto v : miss)
         s.insert(v);
     uint16_t target = PW::max_safe_value;
     s.erase(target); // ensure it's absent
@@ -233,12 +280,14 @@ static void BM_ContainsMiss_PackedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_BucketedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    BucketedSet<kSize> s;
-    for (auto v : kValsMiss)
+    const auto &miss = miss_values<Size>();
+    BucketedSet<Size> s;
+    for (auto v : miss)
         s.insert(v);
-    uint16_t target = BucketedSet<kSize>::max_value;
+    uint16_t target = BucketedSet<Size>::max_value;
     s.erase(target); // ensure it's absent
     for (auto _ : state) {
         bool found = s.contains(target);
@@ -246,9 +295,11 @@ static void BM_ContainsMiss_BucketedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_StdSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::set<uint16_t> s(kValsMiss.begin(), kValsMiss.end());
+    const auto &miss = miss_values<Size>();
+    std::set<uint16_t> s(miss.begin(), miss.end());
     s.erase(PW::max_safe_value);
     for (auto _ : state) {
         bool found = s.count(PW::max_safe_value) > 0;
@@ -256,9 +307,11 @@ static void BM_ContainsMiss_StdSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_UnorderedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::unordered_set<uint16_t> s(kValsMiss.begin(), kValsMiss.end());
+    const auto &miss = miss_values<Size>();
+    std::unordered_set<uint16_t> s(miss.begin(), miss.end());
     s.erase(PW::max_safe_value);
     for (auto _ : state) {
         bool found = s.count(PW::max_safe_value) > 0;
@@ -266,9 +319,11 @@ static void BM_ContainsMiss_UnorderedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_Vector(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::vector<uint16_t> s(kValsMiss.begin(), kValsMiss.end());
+    const auto &miss = miss_values<Size>();
+    std::vector<uint16_t> s(miss.begin(), miss.end());
     auto it = std::find(s.begin(), s.end(), static_cast<uint16_t>(PW::max_safe_value));
     if (it != s.end()) s.erase(it);
     for (auto _ : state) {
@@ -278,9 +333,11 @@ static void BM_ContainsMiss_Vector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_SortedVector(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::vector<uint16_t> s(kValsMiss.begin(), kValsMiss.end());
+    const auto &miss = miss_values<Size>();
+    std::vector<uint16_t> s(miss.begin(), miss.end());
     std::sort(s.begin(), s.end());
     s.erase(std::remove(s.begin(), s.end(), static_cast<uint16_t>(PW::max_safe_value)), s.end());
     for (auto _ : state) {
@@ -290,13 +347,15 @@ static void BM_ContainsMiss_SortedVector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_ContainsMiss_Array(benchmark::State &state) {
     SET_COUNTERS(state);
-    std::array<uint16_t, kSize> arr{};
+    const auto &miss = miss_values<Size>();
+    std::array<uint16_t, Size> arr{};
     std::size_t count = 0;
-    for (std::size_t i = 0; i < kSize; ++i) {
-        if (kValsMiss[i] != PW::max_safe_value)
-            arr[count++] = kValsMiss[i];
+    for (std::size_t i = 0; i < Size; ++i) {
+        if (miss[i] != PW::max_safe_value)
+            arr[count++] = miss[i];
     }
     auto needle = static_cast<uint16_t>(PW::max_safe_value);
     for (auto _ : state) {
@@ -313,11 +372,13 @@ static void BM_ContainsMiss_Array(benchmark::State &state) {
 // Each iteration rebuilds the set so we always erase from a full one.
 // ============================================================
 
+template <std::size_t Size>
 static void BM_Erase_PackedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    PackedSet<N, kSize> base;
-    for (auto v : kVals) base.insert(v);
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    PackedSet<N, Size> base;
+    for (auto v : vals) base.insert(v);
     for (auto _ : state) {
         auto s = base;
         bool ok = s.erase(target);
@@ -326,11 +387,13 @@ static void BM_Erase_PackedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_BucketedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    BucketedSet<kSize> base;
-    for (auto v : kVals) base.insert(v);
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    BucketedSet<Size> base;
+    for (auto v : vals) base.insert(v);
     for (auto _ : state) {
         auto s = base;
         bool ok = s.erase(target);
@@ -339,10 +402,12 @@ static void BM_Erase_BucketedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_StdSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    std::set<uint16_t> base(kVals.begin(), kVals.end());
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    std::set<uint16_t> base(vals.begin(), vals.end());
     for (auto _ : state) {
         auto s = base;
         auto n = s.erase(target);
@@ -351,10 +416,12 @@ static void BM_Erase_StdSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_UnorderedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    std::unordered_set<uint16_t> base(kVals.begin(), kVals.end());
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    std::unordered_set<uint16_t> base(vals.begin(), vals.end());
     for (auto _ : state) {
         auto s = base;
         auto n = s.erase(target);
@@ -363,10 +430,12 @@ static void BM_Erase_UnorderedSet(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_Vector(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    std::vector<uint16_t> base(kVals.begin(), kVals.end());
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    std::vector<uint16_t> base(vals.begin(), vals.end());
     for (auto _ : state) {
         auto s = base;
         auto it = std::find(s.begin(), s.end(), target);
@@ -375,10 +444,12 @@ static void BM_Erase_Vector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_SortedVector(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    std::vector<uint16_t> base(kVals.begin(), kVals.end());
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    std::vector<uint16_t> base(vals.begin(), vals.end());
     std::sort(base.begin(), base.end());
     for (auto _ : state) {
         auto s = base;
@@ -388,14 +459,16 @@ static void BM_Erase_SortedVector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Erase_Array(benchmark::State &state) {
     SET_COUNTERS(state);
-    uint16_t target = kVals[kSize / 2];
-    std::array<uint16_t, kSize> base{};
-    for (std::size_t i = 0; i < kSize; ++i) base[i] = kVals[i];
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    std::array<uint16_t, Size> base{};
+    for (std::size_t i = 0; i < Size; ++i) base[i] = vals[i];
     for (auto _ : state) {
         auto arr = base;
-        std::size_t count = kSize;
+        std::size_t count = Size;
         benchmark::DoNotOptimize(arr.data());
         benchmark::ClobberMemory();
         for (std::size_t i = 0; i < count; ++i) {
@@ -435,57 +508,67 @@ struct TrackingAllocator {
     bool operator!=(const TrackingAllocator<U> &) const noexcept { return false; }
 };
 
+template <std::size_t Size>
 static void BM_Memory_PackedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    using PS = PackedSet<N, kSize>;
+    const auto &vals = hit_values<Size>();
+    using PS = PackedSet<N, Size>;
     state.counters["bytes"] = sizeof(PS);
     for (auto _ : state) {
         PS s;
-        for (auto v : kVals) s.insert(v);
+        for (auto v : vals) s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_BucketedSet(benchmark::State &state) {
     SET_COUNTERS(state);
-    using BS = BucketedSet<kSize>;
+    const auto &vals = hit_values<Size>();
+    using BS = BucketedSet<Size>;
     state.counters["bytes"] = sizeof(BS);
     for (auto _ : state) {
         BS s;
-        for (auto v : kVals) s.insert(v);
+        for (auto v : vals) s.insert(v);
         benchmark::DoNotOptimize(s);
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_StdSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         g_alloc_bytes = 0;
         std::set<uint16_t, std::less<uint16_t>, TrackingAllocator<uint16_t>> s;
-        for (auto v : kVals) s.insert(v);
+        for (auto v : vals) s.insert(v);
         benchmark::DoNotOptimize(s);
         state.counters["bytes"] = sizeof(s) + g_alloc_bytes;
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_UnorderedSet(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         g_alloc_bytes = 0;
         std::unordered_set<uint16_t, std::hash<uint16_t>, std::equal_to<uint16_t>,
                            TrackingAllocator<uint16_t>> s;
-        for (auto v : kVals) s.insert(v);
+        for (auto v : vals) s.insert(v);
         benchmark::DoNotOptimize(s);
         state.counters["bytes"] = sizeof(s) + g_alloc_bytes;
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_Vector(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         g_alloc_bytes = 0;
         std::vector<uint16_t, TrackingAllocator<uint16_t>> s;
-        for (auto v : kVals) {
+        for (auto v : vals) {
             if (std::find(s.begin(), s.end(), v) == s.end())
                 s.push_back(v);
         }
@@ -494,12 +577,14 @@ static void BM_Memory_Vector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_SortedVector(benchmark::State &state) {
     SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
     for (auto _ : state) {
         g_alloc_bytes = 0;
         std::vector<uint16_t, TrackingAllocator<uint16_t>> s;
-        for (auto v : kVals) {
+        for (auto v : vals) {
             auto it = std::lower_bound(s.begin(), s.end(), v);
             if (it == s.end() || *it != v)
                 s.insert(it, v);
@@ -509,13 +594,15 @@ static void BM_Memory_SortedVector(benchmark::State &state) {
     }
 }
 
+template <std::size_t Size>
 static void BM_Memory_Array(benchmark::State &state) {
     SET_COUNTERS(state);
-    state.counters["bytes"] = sizeof(std::array<uint16_t, kSize>);
+    const auto &vals = hit_values<Size>();
+    state.counters["bytes"] = sizeof(std::array<uint16_t, Size>);
     for (auto _ : state) {
-        std::array<uint16_t, kSize> arr{};
+        std::array<uint16_t, Size> arr{};
         std::size_t count = 0;
-        for (auto v : kVals) {
+        for (auto v : vals) {
             bool found = false;
             for (std::size_t i = 0; i < count; ++i) {
                 if (arr[i] == v) { found = true; break; }
@@ -526,46 +613,1068 @@ static void BM_Memory_Array(benchmark::State &state) {
     }
 }
 
+// ============================================================
+// BATCH benchmarks — look up a burst of needles against one set.
+// Needles alternate hit/miss. Scalar variants loop over contains();
+// Many variants use contains_many(). Time is per batch; the
+// "per_needle" counter divides it by the batch size.
+// ============================================================
+
+// Batch lookups always run against a set of kBatchSetSize elements.
+static constexpr std::size_t kBatchSetSize = 5;
+static const auto &kBatchVals = hit_values<kBatchSetSize>();
+static const auto &kBatchValsMiss = miss_values<kBatchSetSize>();
+
+static std::vector<uint16_t> make_needles(std::size_t count) {
+    std::vector<uint16_t> out(count);
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = (i & 1) ? kBatchValsMiss[i % kBatchSetSize]
+                         : kBatchVals[i % kBatchSetSize];
+    return out;
+}
+
+#define SET_BATCH_COUNTERS(state, batch)                                       \
+    state.counters["N"] = N;                                                   \
+    state.counters["size"] = kBatchSetSize;                                    \
+    state.counters["batch"] = static_cast<double>(batch);                      \
+    state.counters["per_needle"] = benchmark::Counter(                         \
+        static_cast<double>(batch),                                            \
+        benchmark::Counter::kIsIterationInvariantRate |                        \
+            benchmark::Counter::kInvert);
+
+template <class Set>
+static void run_batch_scalar(benchmark::State &state, const Set &s) {
+    auto batch = static_cast<std::size_t>(state.range(0));
+    SET_BATCH_COUNTERS(state, batch);
+    auto needles = make_needles(batch);
+    std::unique_ptr<bool[]> out(new bool[batch]);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < batch; ++i)
+            out[i] = s.contains(needles[i]);
+        benchmark::DoNotOptimize(out.get());
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_ContainsBatchScalar_PackedSet(benchmark::State &state) {
+    PackedSet<N, kBatchSetSize> s;
+    for (auto v : kBatchVals)
+        s.insert(v);
+    run_batch_scalar(state, s);
+}
+
+static void BM_ContainsBatchScalar_BucketedSet(benchmark::State &state) {
+    BucketedSet<kBatchSetSize> s;
+    for (auto v : kBatchVals)
+        s.insert(v);
+    run_batch_scalar(state, s);
+}
+
+static void BM_ContainsMany_PackedSet(benchmark::State &state) {
+    PackedSet<N, kBatchSetSize> s;
+    for (auto v : kBatchVals)
+        s.insert(v);
+    auto batch = static_cast<std::size_t>(state.range(0));
+    SET_BATCH_COUNTERS(state, batch);
+    auto raw = make_needles(batch);
+    std::vector<uint64_t> needles(raw.begin(), raw.end());
+    std::unique_ptr<bool[]> out(new bool[batch]);
+    for (auto _ : state) {
+        s.contains_many(needles.data(), batch, out.get());
+        benchmark::DoNotOptimize(out.get());
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_ContainsMany_BucketedSet(benchmark::State &state) {
+    BucketedSet<kBatchSetSize> s;
+    for (auto v : kBatchVals)
+        s.insert(v);
+    auto batch = static_cast<std::size_t>(state.range(0));
+    SET_BATCH_COUNTERS(state, batch);
+    auto needles = make_needles(batch);
+    std::unique_ptr<bool[]> out(new bool[batch]);
+    for (auto _ : state) {
+        s.contains_many(needles.data(), batch, out.get());
+        benchmark::DoNotOptimize(out.get());
+        benchmark::ClobberMemory();
+    }
+}
+
+// ============================================================
+// INSERT-at-fill benchmarks — one insert into a set pre-filled to
+// state.range(0) percent of kFillCapacity. At 100% the insert is
+// rejected. Each iteration copies the pre-filled set; the copy cost is
+// the same for both containers.
+// ============================================================
+
+static constexpr std::size_t kFillCapacity = 64;
+static const auto kFillVals = make_values(kFillCapacity + 1, 7);
+
+template <class Set>
+static void run_insert_at_fill(benchmark::State &state) {
+    auto fill = kFillCapacity * static_cast<std::size_t>(state.range(0)) / 100;
+    state.counters["N"] = N;
+    state.counters["size"] = static_cast<double>(fill);
+    Set base;
+    for (std::size_t i = 0; i < fill; ++i)
+        base.insert(kFillVals[i]);
+    uint16_t v = kFillVals[kFillCapacity];
+    for (auto _ : state) {
+        Set s = base;
+        benchmark::DoNotOptimize(s);
+        bool inserted = s.insert(v);
+        benchmark::DoNotOptimize(inserted);
+    }
+}
+
+static void BM_InsertAtFill_PackedSet(benchmark::State &state) {
+    run_insert_at_fill<PackedSet<N, kFillCapacity>>(state);
+}
+
+static void BM_InsertAtFill_CountedPackedSet(benchmark::State &state) {
+    run_insert_at_fill<CountedPackedSet<N, kFillCapacity>>(state);
+}
+
+// ============================================================
+// BUILD benchmarks — fill a BucketedSet from scratch to capacity.
+// Values cover the full 11-bit range so both halves are used.
+// ============================================================
+
+static const auto kBuildVals = [] {
+    std::mt19937_64 rng(3);
+    std::vector<uint16_t> all(BucketedSet<1>::max_value);
+    for (std::size_t i = 0; i < all.size(); ++i)
+        all[i] = static_cast<uint16_t>(i + 1);
+    std::shuffle(all.begin(), all.end(), rng);
+    return all;
+}();
+
+template <std::size_t Cap>
+static void BM_Build_BucketedSet(benchmark::State &state) {
+    state.counters["N"] = 11;
+    state.counters["size"] = Cap;
+    // Split the values evenly between the lo and hi halves.
+    std::vector<uint16_t> vals;
+    std::size_t per_half[2] = {0, 0};
+    for (auto v : kBuildVals) {
+        auto &n = per_half[v >> 10];
+        if (n < Cap / 2 + Cap % 2) {
+            vals.push_back(v);
+            ++n;
+        }
+        if (vals.size() == Cap)
+            break;
+    }
+    for (auto _ : state) {
+        BucketedSet<Cap> s;
+        for (auto v : vals)
+            s.insert(v);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+// ============================================================
+// PARTITION benchmarks — BasicBucketedSet<16, P, kPartCapacity>
+// contains for 2, 4, 8 and 16 partitions at a fixed capacity. Each
+// lookup scans one partition; more partition bits also mean more lanes
+// per bucket. Needles cycle through the stored values (all hits).
+// ============================================================
+
+static constexpr std::size_t kPartCapacity = 64;
+
+template <unsigned P>
+static void BM_ContainsPartitions_BucketedSet(benchmark::State &state) {
+    using S = BasicBucketedSet<16, P, kPartCapacity>;
+    state.counters["partitions"] = static_cast<double>(S::partitions);
+    state.counters["lanes"] = S::lanes_per_bucket;
+    state.counters["size"] = kPartCapacity;
+    state.counters["bytes"] = sizeof(S);
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<uint32_t> dist(1, S::max_value);
+    S s;
+    std::vector<uint16_t> vals;
+    while (vals.size() < kPartCapacity) {
+        auto v = static_cast<uint16_t>(dist(rng));
+        if (s.insert(v))
+            vals.push_back(v);
+    }
+    std::size_t i = 0;
+    for (auto _ : state) {
+        bool found = s.contains(vals[i]);
+        benchmark::DoNotOptimize(found);
+        i = (i + 1) % vals.size();
+    }
+}
+
+// ============================================================
+// HASH benchmarks — PackedHashSet vs PackedSet vs std::unordered_set
+// from 16 to 64K elements. Uses N=18 (max_safe_value=131071, 3 lanes per
+// word) so 64K distinct values fit. Sets live on the heap; lookups cycle
+// through the stored values (all hits).
+// ============================================================
+
+static constexpr unsigned kHashN = 18;
+
+static std::vector<uint32_t> make_hash_values(std::size_t count) {
+    std::mt19937_64 rng(17);
+    std::uniform_int_distribution<uint32_t> dist(
+        1, PackedWord<kHashN>::max_safe_value);
+    std::unordered_set<uint32_t> seen;
+    std::vector<uint32_t> out;
+    out.reserve(count);
+    while (out.size() < count) {
+        auto v = dist(rng);
+        if (seen.insert(v).second)
+            out.push_back(v);
+    }
+    return out;
+}
+
+template <class Set, std::size_t Size>
+static void run_hash_contains(benchmark::State &state) {
+    state.counters["N"] = kHashN;
+    state.counters["size"] = Size;
+    auto vals = make_hash_values(Size);
+    auto s = std::make_unique<Set>();
+    for (auto v : vals)
+        s->insert(v);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        bool found = s->count(vals[i]) != 0;
+        benchmark::DoNotOptimize(found);
+        if (++i == Size)
+            i = 0;
+    }
+}
+
+// Adapts the SWAR sets to the count() spelling used above.
+template <class Set> struct CountAdapter : Set {
+    std::size_t count(uint64_t v) const { return this->contains(v) ? 1 : 0; }
+};
+
+template <std::size_t Size>
+static void BM_HashContains_PackedHashSet(benchmark::State &state) {
+    run_hash_contains<CountAdapter<PackedHashSet<kHashN, Size>>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_HashContains_PackedSet(benchmark::State &state) {
+    run_hash_contains<CountAdapter<PackedSet<kHashN, Size>>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_HashContains_UnorderedSet(benchmark::State &state) {
+    run_hash_contains<std::unordered_set<uint32_t>, Size>(state);
+}
+
+#define REGISTER_HASH_SIZES(BM)                                                \
+    BENCHMARK_TEMPLATE(BM, 16);                                                \
+    BENCHMARK_TEMPLATE(BM, 64);                                                \
+    BENCHMARK_TEMPLATE(BM, 256);                                               \
+    BENCHMARK_TEMPLATE(BM, 1024);                                              \
+    BENCHMARK_TEMPLATE(BM, 4096);                                              \
+    BENCHMARK_TEMPLATE(BM, 16384);                                             \
+    BENCHMARK_TEMPLATE(BM, 65536);
+
+// ============================================================
+// SORTED benchmarks — SortedPackedSet through the core size sweep, plus
+// range counting against the sorted-vector baseline. Registered with
+// REGISTER_SIZES, so they plot alongside the core suite.
+// ============================================================
+
+template <std::size_t Size>
+static void BM_Insert_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    for (auto _ : state) {
+        SortedPackedSet<N, Size> s;
+        for (auto v : vals)
+            s.insert(v);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Contains_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    SortedPackedSet<N, Size> s;
+    for (auto v : vals)
+        s.insert(v);
+    uint16_t target = vals[Size / 2];
+    for (auto _ : state) {
+        bool found = s.contains(target);
+        benchmark::DoNotOptimize(found);
+    }
+}
+
+template <std::size_t Size>
+static void BM_ContainsMiss_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &miss = miss_values<Size>();
+    SortedPackedSet<N, Size> s;
+    for (auto v : miss)
+        s.insert(v);
+    uint16_t target = PW::max_safe_value;
+    s.erase(target); // ensure it's absent
+    for (auto _ : state) {
+        bool found = s.contains(target);
+        benchmark::DoNotOptimize(found);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Erase_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    uint16_t target = vals[Size / 2];
+    SortedPackedSet<N, Size> base;
+    for (auto v : vals) base.insert(v);
+    for (auto _ : state) {
+        auto s = base;
+        bool ok = s.erase(target);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Memory_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    using SPS = SortedPackedSet<N, Size>;
+    state.counters["bytes"] = sizeof(SPS);
+    for (auto _ : state) {
+        SPS s;
+        for (auto v : vals) s.insert(v);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+// Range: count the elements in the middle half of the value space.
+static constexpr uint16_t kRangeLo = PW::max_safe_value / 4;
+static constexpr uint16_t kRangeHi = PW::max_safe_value / 4 * 3;
+
+template <std::size_t Size>
+static void BM_Range_SortedPackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    SortedPackedSet<N, Size> s;
+    for (auto v : vals)
+        s.insert(v);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        auto n = s.count_in_range(kRangeLo, kRangeHi);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Range_SortedVector(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    std::vector<uint16_t> s(vals.begin(), vals.end());
+    std::sort(s.begin(), s.end());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s.data());
+        auto n = std::upper_bound(s.begin(), s.end(), kRangeHi) -
+                 std::lower_bound(s.begin(), s.end(), kRangeLo);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Range_PackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    PackedSet<N, Size> s;
+    for (auto v : vals)
+        s.insert(v);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        auto n = s.count_in_range(kRangeLo, kRangeHi);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+// ============================================================
+// ALGEBRA benchmarks — intersect two sets of Size elements that share
+// half their values. The baseline is std::set_intersection over two
+// sorted vectors; the packed sets compare whole words at a time.
+// ============================================================
+
+/// Size distinct values, the first half shared with hit_values<Size>().
+template <std::size_t Size> static const std::vector<uint16_t> &other_values() {
+    static const auto vals = [] {
+        const auto &hit = hit_values<Size>();
+        std::vector<uint16_t> out(hit.begin(), hit.begin() + Size / 2);
+        std::unordered_set<uint16_t> used(hit.begin(), hit.end());
+        for (auto v : make_values(2 * Size, 7)) {
+            if (out.size() < Size && used.insert(v).second)
+                out.push_back(v);
+        }
+        return out;
+    }();
+    return vals;
+}
+
+template <class Set, std::size_t Size> static Set make_set(bool other) {
+    Set s;
+    for (auto v : other ? other_values<Size>() : hit_values<Size>())
+        s.insert(v);
+    return s;
+}
+
+template <std::size_t Size>
+static void BM_Intersect_PackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto a = make_set<PackedSet<N, Size>, Size>(false);
+    auto b = make_set<PackedSet<N, Size>, Size>(true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto r = a.intersect(b);
+        benchmark::DoNotOptimize(r);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Intersect_BucketedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto a = make_set<BucketedSet<Size>, Size>(false);
+    auto b = make_set<BucketedSet<Size>, Size>(true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto r = a.intersect(b);
+        benchmark::DoNotOptimize(r);
+    }
+}
+
+template <std::size_t Size>
+static void BM_Intersect_SortedVector(benchmark::State &state) {
+    SET_COUNTERS(state);
+    std::vector<uint16_t> a(hit_values<Size>()), b(other_values<Size>());
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    std::vector<uint16_t> r;
+    r.reserve(Size);
+    for (auto _ : state) {
+        r.clear();
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                              std::back_inserter(r));
+        benchmark::DoNotOptimize(r.data());
+    }
+}
+
+template <std::size_t Size>
+static void BM_IntersectSize_PackedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto a = make_set<PackedSet<N, Size>, Size>(false);
+    auto b = make_set<PackedSet<N, Size>, Size>(true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto n = a.intersection_size(b);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+template <std::size_t Size>
+static void BM_IntersectSize_BucketedSet(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto a = make_set<BucketedSet<Size>, Size>(false);
+    auto b = make_set<BucketedSet<Size>, Size>(true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto n = a.intersection_size(b);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+template <std::size_t Size>
+static void BM_IntersectSize_SortedVector(benchmark::State &state) {
+    SET_COUNTERS(state);
+    std::vector<uint16_t> a(hit_values<Size>()), b(other_values<Size>());
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.data());
+        std::size_t n = 0;
+        auto i = a.begin(), j = b.begin();
+        while (i != a.end() && j != b.end()) {
+            if (*i < *j) {
+                ++i;
+            } else if (*j < *i) {
+                ++j;
+            } else {
+                ++n;
+                ++i;
+                ++j;
+            }
+        }
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+// ============================================================
+// ITERATE benchmarks — visit every element of a set of Size elements
+// and sum them. PackedSet and BucketedSet run both the iterator and
+// for_each; std::set and std::vector are the baselines (the vector is
+// the shadow copy the packed sets used to need for enumeration).
+// ============================================================
+
+template <class Set, std::size_t Size>
+static void run_iterate(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto s = make_set<Set, Size>(false);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        uint64_t sum = 0;
+        for (auto v : s)
+            sum += v;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(Size));
+}
+
+template <class Set, std::size_t Size>
+static void run_for_each(benchmark::State &state) {
+    SET_COUNTERS(state);
+    auto s = make_set<Set, Size>(false);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        uint64_t sum = 0;
+        s.for_each([&](uint64_t v) { sum += v; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(Size));
+}
+
+template <std::size_t Size>
+static void BM_Iterate_PackedSet(benchmark::State &state) {
+    run_iterate<PackedSet<N, Size>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_Iterate_BucketedSet(benchmark::State &state) {
+    run_iterate<BucketedSet<Size>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_ForEach_PackedSet(benchmark::State &state) {
+    run_for_each<PackedSet<N, Size>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_ForEach_BucketedSet(benchmark::State &state) {
+    run_for_each<BucketedSet<Size>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_Iterate_StdSet(benchmark::State &state) {
+    run_iterate<std::set<uint16_t>, Size>(state);
+}
+
+template <std::size_t Size>
+static void BM_Iterate_Vector(benchmark::State &state) {
+    SET_COUNTERS(state);
+    const auto &vals = hit_values<Size>();
+    std::vector<uint16_t> v(vals.begin(), vals.end());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v.data());
+        uint64_t sum = 0;
+        for (auto x : v)
+            sum += x;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(Size));
+}
+
+// ============================================================
+// WORKING SET benchmarks — many small sets, one per entity, far larger
+// than the last-level cache. Every set holds kEntitySize values; each
+// iteration picks a random entity, so the cost is dominated by the cache
+// miss on that entity's set rather than by the scan itself. The argument
+// is the entity count (a power of two); bytes_per_set includes heap
+// allocations.
+// ============================================================
+
+static constexpr std::size_t kEntitySize = 5;
+
+/// j-th value of entity e: distinct for j < kEntitySize, spread over
+/// [1, max_safe_value] so neighbouring entities hold different values.
+static uint16_t entity_value(std::size_t e, std::size_t j) {
+    uint64_t h = (e + 1) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<uint16_t>(1 + ((h >> 40) + j * 197) % PW::max_safe_value);
+}
+
+/// xorshift64: cheap enough not to show up next to a cache miss.
+static uint64_t next_random(uint64_t &s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+// Per-container policies: the set type plus insert/contains/erase.
+
+struct EntityPackedSet {
+    using Set = PackedSet<N, kEntitySize>;
+    static void insert(Set &s, uint16_t v) { s.insert(v); }
+    static bool contains(const Set &s, uint16_t v) { return s.contains(v); }
+    static void erase(Set &s, uint16_t v) { s.erase(v); }
+};
+
+struct EntityBucketedSet {
+    using Set = BucketedSet<kEntitySize>;
+    static void insert(Set &s, uint16_t v) { s.insert(v); }
+    static bool contains(const Set &s, uint16_t v) { return s.contains(v); }
+    static void erase(Set &s, uint16_t v) { s.erase(v); }
+};
+
+struct EntityStdSet {
+    using Set = std::set<uint16_t, std::less<uint16_t>, TrackingAllocator<uint16_t>>;
+    static void insert(Set &s, uint16_t v) { s.insert(v); }
+    static bool contains(const Set &s, uint16_t v) { return s.count(v) > 0; }
+    static void erase(Set &s, uint16_t v) { s.erase(v); }
+};
+
+struct EntityUnorderedSet {
+    using Set = std::unordered_set<uint16_t, std::hash<uint16_t>,
+                                   std::equal_to<uint16_t>,
+                                   TrackingAllocator<uint16_t>>;
+    static void insert(Set &s, uint16_t v) { s.insert(v); }
+    static bool contains(const Set &s, uint16_t v) { return s.count(v) > 0; }
+    static void erase(Set &s, uint16_t v) { s.erase(v); }
+};
+
+struct EntityVector {
+    using Set = std::vector<uint16_t, TrackingAllocator<uint16_t>>;
+    static void insert(Set &s, uint16_t v) {
+        if (s.empty())
+            s.reserve(kEntitySize);
+        if (std::find(s.begin(), s.end(), v) == s.end())
+            s.push_back(v);
+    }
+    static bool contains(const Set &s, uint16_t v) {
+        return std::find(s.begin(), s.end(), v) != s.end();
+    }
+    static void erase(Set &s, uint16_t v) {
+        auto it = std::find(s.begin(), s.end(), v);
+        if (it != s.end()) {
+            *it = s.back();
+            s.pop_back();
+        }
+    }
+};
+
+struct EntitySortedVector {
+    using Set = std::vector<uint16_t, TrackingAllocator<uint16_t>>;
+    static void insert(Set &s, uint16_t v) {
+        if (s.empty())
+            s.reserve(kEntitySize);
+        auto it = std::lower_bound(s.begin(), s.end(), v);
+        if (it == s.end() || *it != v)
+            s.insert(it, v);
+    }
+    static bool contains(const Set &s, uint16_t v) {
+        return std::binary_search(s.begin(), s.end(), v);
+    }
+    static void erase(Set &s, uint16_t v) {
+        auto it = std::lower_bound(s.begin(), s.end(), v);
+        if (it != s.end() && *it == v)
+            s.erase(it);
+    }
+};
+
+struct EntityArray {
+    struct Set {
+        std::array<uint16_t, kEntitySize> vals{};
+        uint8_t count = 0;
+    };
+    static void insert(Set &s, uint16_t v) {
+        if (!contains(s, v) && s.count < kEntitySize)
+            s.vals[s.count++] = v;
+    }
+    static bool contains(const Set &s, uint16_t v) {
+        for (std::size_t i = 0; i < s.count; ++i) {
+            if (s.vals[i] == v)
+                return true;
+        }
+        return false;
+    }
+    static void erase(Set &s, uint16_t v) {
+        for (std::size_t i = 0; i < s.count; ++i) {
+            if (s.vals[i] == v) {
+                s.vals[i] = s.vals[--s.count];
+                return;
+            }
+        }
+    }
+};
+
+/// Build one set per entity holding its first `fill` values and record
+/// the counters shared by the working-set benchmarks.
+template <class P>
+static std::vector<typename P::Set> make_entities(benchmark::State &state,
+                                                  std::size_t entities,
+                                                  std::size_t fill) {
+    g_alloc_bytes = 0;
+    std::vector<typename P::Set> sets(entities);
+    for (std::size_t e = 0; e < entities; ++e) {
+        for (std::size_t j = 0; j < fill; ++j)
+            P::insert(sets[e], entity_value(e, j));
+    }
+    double bytes = sizeof(typename P::Set) +
+                   static_cast<double>(g_alloc_bytes) / entities;
+    state.counters["N"] = N;
+    state.counters["size"] = kEntitySize;
+    state.counters["entities"] = static_cast<double>(entities);
+    state.counters["bytes_per_set"] = bytes;
+    state.counters["working_set_MiB"] = bytes * entities / (1 << 20);
+    return sets;
+}
+
+/// Random-entity lookups, alternating hits and misses.
+template <class P> static void run_working_set_contains(benchmark::State &state) {
+    const auto entities = static_cast<std::size_t>(state.range(0));
+    auto sets = make_entities<P>(state, entities, kEntitySize);
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        std::size_t e = next_random(rng) & (entities - 1);
+        // j == kEntitySize is never stored: a miss in the same value range.
+        std::size_t j = (i++ & 1) ? kEntitySize : e % kEntitySize;
+        bool found = P::contains(sets[e], entity_value(e, j));
+        benchmark::DoNotOptimize(found);
+    }
+}
+
+/// Random-entity inserts of each entity's last value into sets holding
+/// kEntitySize - 1. Entities are visited in a random permutation; when it
+/// wraps, the inserted values are erased again with the timer paused.
+template <class P> static void run_working_set_insert(benchmark::State &state) {
+    const auto entities = static_cast<std::size_t>(state.range(0));
+    auto sets = make_entities<P>(state, entities, kEntitySize - 1);
+    std::vector<uint32_t> order(entities);
+    for (std::size_t e = 0; e < entities; ++e)
+        order[e] = static_cast<uint32_t>(e);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        if (i == entities) {
+            state.PauseTiming();
+            for (std::size_t e = 0; e < entities; ++e)
+                P::erase(sets[e], entity_value(e, kEntitySize - 1));
+            i = 0;
+            state.ResumeTiming();
+        }
+        std::size_t e = order[i++];
+        P::insert(sets[e], entity_value(e, kEntitySize - 1));
+        benchmark::DoNotOptimize(sets[e]);
+    }
+}
+
+#define DEFINE_WORKING_SET(NAME)                                               \
+    static void BM_WorkingSetContains_##NAME(benchmark::State &state) {        \
+        run_working_set_contains<Entity##NAME>(state);                         \
+    }                                                                          \
+    static void BM_WorkingSetInsert_##NAME(benchmark::State &state) {          \
+        run_working_set_insert<Entity##NAME>(state);                           \
+    }
+
+DEFINE_WORKING_SET(PackedSet)
+DEFINE_WORKING_SET(BucketedSet)
+DEFINE_WORKING_SET(StdSet)
+DEFINE_WORKING_SET(UnorderedSet)
+DEFINE_WORKING_SET(Vector)
+DEFINE_WORKING_SET(SortedVector)
+DEFINE_WORKING_SET(Array)
+
+// Arena variants: sets of kArenaCapacity values (3 words, so the dense
+// stride of 24 bytes straddles cache lines and the aligned stride is 32).
+// Lookups run in batches of kArenaBatch random (entity, value) pairs,
+// either one contains() at a time or through contains_many (prefetch).
+
+static constexpr std::size_t kArenaCapacity = 12;
+static constexpr std::size_t kArenaBatch = 1024;
+
+template <bool Aligned, bool Bulk>
+static void run_arena_contains(benchmark::State &state) {
+    using Arena = PackedSetArena<N, kArenaCapacity, Aligned>;
+    const auto entities = static_cast<std::size_t>(state.range(0));
+    Arena arena(entities);
+    for (std::size_t e = 0; e < entities; ++e) {
+        for (std::size_t j = 0; j < kArenaCapacity; ++j)
+            arena.insert(static_cast<uint32_t>(e), entity_value(e, j));
+    }
+    std::vector<uint32_t> handles(kArenaBatch);
+    std::vector<uint64_t> values(kArenaBatch);
+    std::unique_ptr<bool[]> out(new bool[kArenaBatch]);
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (std::size_t i = 0; i < kArenaBatch; ++i) {
+            std::size_t e = next_random(rng) & (entities - 1);
+            handles[i] = static_cast<uint32_t>(e);
+            values[i] = entity_value(e, (i & 1) ? kArenaCapacity : e % kArenaCapacity);
+        }
+        state.ResumeTiming();
+        if constexpr (Bulk) {
+            arena.contains_many(handles.data(), values.data(), kArenaBatch,
+                                out.get());
+        } else {
+            for (std::size_t i = 0; i < kArenaBatch; ++i)
+                out[i] = arena.contains(handles[i], values[i]);
+        }
+        benchmark::DoNotOptimize(out.get());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kArenaBatch);
+    state.counters["N"] = N;
+    state.counters["size"] = kArenaCapacity;
+    state.counters["entities"] = static_cast<double>(entities);
+    state.counters["bytes_per_set"] = Arena::bytes_per_set();
+}
+
+static void BM_WorkingSetContains_PackedSetArena(benchmark::State &state) {
+    run_arena_contains<false, false>(state);
+}
+static void BM_WorkingSetContains_PackedSetArenaAligned(benchmark::State &state) {
+    run_arena_contains<true, false>(state);
+}
+static void BM_WorkingSetContainsMany_PackedSetArena(benchmark::State &state) {
+    run_arena_contains<false, true>(state);
+}
+static void BM_WorkingSetContainsMany_PackedSetArenaAligned(benchmark::State &state) {
+    run_arena_contains<true, true>(state);
+}
+
+// ============================================================
+// CHURN benchmarks — PackedSet<N, kChurnCapacity> under a steady
+// insert/erase mix, with each erase policy. The set holds state.range(0)
+// live values; a churn step erases a random live value and inserts a
+// random absent one. Setup runs kChurnWarmup steps first so the layout
+// reaches steady state. ChurnLookup then times lookups alone (hits and
+// misses alternate); Churn times one step plus two lookups.
+// ============================================================
+
+static constexpr std::size_t kChurnCapacity = 128;
+static constexpr std::size_t kChurnWarmup = 64 * kChurnCapacity;
+static constexpr std::size_t kChurnNeedles = 1024;
+
+template <class Erase> struct ChurnState {
+    PackedSet<N, kChurnCapacity, GuardedZero, Erase> set;
+    std::vector<uint16_t> live, absent;
+    uint64_t rng = 0x9e3779b97f4a7c15ull;
+
+    explicit ChurnState(std::size_t count) {
+        absent = make_values(PW::max_safe_value, 3);
+        live.assign(absent.end() - static_cast<std::ptrdiff_t>(count),
+                    absent.end());
+        absent.resize(absent.size() - count);
+        for (auto v : live)
+            set.insert(v);
+        for (std::size_t i = 0; i < kChurnWarmup; ++i)
+            step();
+    }
+
+    void step() {
+        auto &out = live[next_random(rng) % live.size()];
+        auto &in = absent[next_random(rng) % absent.size()];
+        set.erase(out);
+        set.insert(in);
+        std::swap(out, in);
+    }
+
+    uint16_t needle(std::size_t i) {
+        return i % 2 ? absent[next_random(rng) % absent.size()]
+                     : live[next_random(rng) % live.size()];
+    }
+};
+
+template <class Erase>
+static void run_churn_lookup(benchmark::State &state) {
+    ChurnState<Erase> c(static_cast<std::size_t>(state.range(0)));
+    std::vector<uint16_t> needles(kChurnNeedles);
+    for (std::size_t i = 0; i < kChurnNeedles; ++i)
+        needles[i] = c.needle(i);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        bool found = c.set.contains(needles[i]);
+        benchmark::DoNotOptimize(found);
+        i = (i + 1) % kChurnNeedles;
+    }
+    state.counters["live_words"] = static_cast<double>(c.set.live_words());
+    state.counters["words"] = static_cast<double>(c.set.num_words);
+}
+
+template <class Erase> static void run_churn(benchmark::State &state) {
+    ChurnState<Erase> c(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        c.step();
+        bool hit = c.set.contains(c.needle(0));
+        bool miss = c.set.contains(c.needle(1));
+        benchmark::DoNotOptimize(hit);
+        benchmark::DoNotOptimize(miss);
+    }
+}
+
+static void BM_ChurnLookup_InPlace(benchmark::State &state) {
+    run_churn_lookup<EraseInPlace>(state);
+}
+static void BM_ChurnLookup_Compact(benchmark::State &state) {
+    run_churn_lookup<EraseCompact>(state);
+}
+static void BM_Churn_InPlace(benchmark::State &state) {
+    run_churn<EraseInPlace>(state);
+}
+static void BM_Churn_Compact(benchmark::State &state) {
+    run_churn<EraseCompact>(state);
+}
+
+// 1K entities fit in L1/L2. Inline layouts go up to 32M entities: even
+// the densest (PackedSet<11,5>, 8 bytes) is then 256 MiB, several times
+// a large server LLC (100+ MiB). Heap-backed containers stop at 4M, where
+// their 34-248 bytes per set are already 136 MiB to 1 GiB; 32M of them
+// would not fit in memory on a typical benchmark host.
+#define REGISTER_WORKING_SET(BM)                                               \
+    BENCHMARK(BM)->RangeMultiplier(8)->Range(1 << 10, 1 << 25)
+#define REGISTER_WORKING_SET_HEAP(BM)                                          \
+    BENCHMARK(BM)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)
+
+#define REGISTER_ALGEBRA_SIZES(BM)                                             \
+    BENCHMARK_TEMPLATE(BM, 5);                                                 \
+    BENCHMARK_TEMPLATE(BM, 8);                                                 \
+    BENCHMARK_TEMPLATE(BM, 16);                                                \
+    BENCHMARK_TEMPLATE(BM, 32);                                                \
+    BENCHMARK_TEMPLATE(BM, 64);                                                \
+    BENCHMARK_TEMPLATE(BM, 128);                                               \
+    BENCHMARK_TEMPLATE(BM, 256);
+
 // ============================================================
 // Register all benchmarks
 // ============================================================
 
-BENCHMARK(BM_Insert_PackedSet);
-BENCHMARK(BM_Insert_BucketedSet);
-BENCHMARK(BM_Insert_StdSet);
-BENCHMARK(BM_Insert_UnorderedSet);
-BENCHMARK(BM_Insert_Vector);
-BENCHMARK(BM_Insert_SortedVector);
-BENCHMARK(BM_Insert_Array);
-
-BENCHMARK(BM_Contains_PackedSet);
-BENCHMARK(BM_Contains_BucketedSet);
-BENCHMARK(BM_Contains_StdSet);
-BENCHMARK(BM_Contains_UnorderedSet);
-BENCHMARK(BM_Contains_Vector);
-BENCHMARK(BM_Contains_SortedVector);
-BENCHMARK(BM_Contains_Array);
-
-BENCHMARK(BM_ContainsMiss_PackedSet);
-BENCHMARK(BM_ContainsMiss_BucketedSet);
-BENCHMARK(BM_ContainsMiss_StdSet);
-BENCHMARK(BM_ContainsMiss_UnorderedSet);
-BENCHMARK(BM_ContainsMiss_Vector);
-BENCHMARK(BM_ContainsMiss_SortedVector);
-BENCHMARK(BM_ContainsMiss_Array);
-
-BENCHMARK(BM_Erase_PackedSet);
-BENCHMARK(BM_Erase_BucketedSet);
-BENCHMARK(BM_Erase_StdSet);
-BENCHMARK(BM_Erase_UnorderedSet);
-BENCHMARK(BM_Erase_Vector);
-BENCHMARK(BM_Erase_SortedVector);
-BENCHMARK(BM_Erase_Array);
-
-BENCHMARK(BM_Memory_PackedSet);
-BENCHMARK(BM_Memory_BucketedSet);
-BENCHMARK(BM_Memory_StdSet);
-BENCHMARK(BM_Memory_UnorderedSet);
-BENCHMARK(BM_Memory_Vector);
-BENCHMARK(BM_Memory_SortedVector);
-BENCHMARK(BM_Memory_Array);
+#define REGISTER_SIZES(BM)                                                     \
+    BENCHMARK_TEMPLATE(BM, 1);                                                 \
+    BENCHMARK_TEMPLATE(BM, 2);                                                 \
+    BENCHMARK_TEMPLATE(BM, 4);                                                 \
+    BENCHMARK_TEMPLATE(BM, 8);                                                 \
+    BENCHMARK_TEMPLATE(BM, 16);                                                \
+    BENCHMARK_TEMPLATE(BM, 32);                                                \
+    BENCHMARK_TEMPLATE(BM, 64);                                                \
+    BENCHMARK_TEMPLATE(BM, 128);                                               \
+    BENCHMARK_TEMPLATE(BM, 256);                                               \
+    BENCHMARK_TEMPLATE(BM, 512);
+
+REGISTER_SIZES(BM_Insert_PackedSet)
+REGISTER_SIZES(BM_Insert_BucketedSet)
+REGISTER_SIZES(BM_Insert_StdSet)
+REGISTER_SIZES(BM_Insert_UnorderedSet)
+REGISTER_SIZES(BM_Insert_Vector)
+REGISTER_SIZES(BM_Insert_SortedVector)
+REGISTER_SIZES(BM_Insert_SortedPackedSet)
+REGISTER_SIZES(BM_Insert_Array)
+
+REGISTER_SIZES(BM_Contains_PackedSet)
+REGISTER_SIZES(BM_Contains_BucketedSet)
+REGISTER_SIZES(BM_Contains_StdSet)
+REGISTER_SIZES(BM_Contains_UnorderedSet)
+REGISTER_SIZES(BM_Contains_Vector)
+REGISTER_SIZES(BM_Contains_SortedVector)
+REGISTER_SIZES(BM_Contains_SortedPackedSet)
+REGISTER_SIZES(BM_Contains_Array)
+
+REGISTER_SIZES(BM_ContainsMiss_PackedSet)
+REGISTER_SIZES(BM_ContainsMiss_BucketedSet)
+REGISTER_SIZES(BM_ContainsMiss_StdSet)
+REGISTER_SIZES(BM_ContainsMiss_UnorderedSet)
+REGISTER_SIZES(BM_ContainsMiss_Vector)
+REGISTER_SIZES(BM_ContainsMiss_SortedVector)
+REGISTER_SIZES(BM_ContainsMiss_SortedPackedSet)
+REGISTER_SIZES(BM_ContainsMiss_Array)
+
+REGISTER_SIZES(BM_Erase_PackedSet)
+REGISTER_SIZES(BM_Erase_BucketedSet)
+REGISTER_SIZES(BM_Erase_StdSet)
+REGISTER_SIZES(BM_Erase_UnorderedSet)
+REGISTER_SIZES(BM_Erase_Vector)
+REGISTER_SIZES(BM_Erase_SortedVector)
+REGISTER_SIZES(BM_Erase_SortedPackedSet)
+REGISTER_SIZES(BM_Erase_Array)
+
+REGISTER_SIZES(BM_Memory_PackedSet)
+REGISTER_SIZES(BM_Memory_BucketedSet)
+REGISTER_SIZES(BM_Memory_StdSet)
+REGISTER_SIZES(BM_Memory_UnorderedSet)
+REGISTER_SIZES(BM_Memory_Vector)
+REGISTER_SIZES(BM_Memory_SortedVector)
+REGISTER_SIZES(BM_Memory_SortedPackedSet)
+REGISTER_SIZES(BM_Memory_Array)
+
+REGISTER_SIZES(BM_Range_SortedPackedSet)
+REGISTER_SIZES(BM_Range_SortedVector)
+REGISTER_SIZES(BM_Range_PackedSet)
+
+REGISTER_ALGEBRA_SIZES(BM_Intersect_PackedSet)
+REGISTER_ALGEBRA_SIZES(BM_Intersect_BucketedSet)
+REGISTER_ALGEBRA_SIZES(BM_Intersect_SortedVector)
+REGISTER_ALGEBRA_SIZES(BM_IntersectSize_PackedSet)
+REGISTER_ALGEBRA_SIZES(BM_IntersectSize_BucketedSet)
+REGISTER_ALGEBRA_SIZES(BM_IntersectSize_SortedVector)
+
+REGISTER_SIZES(BM_Iterate_PackedSet)
+REGISTER_SIZES(BM_Iterate_BucketedSet)
+REGISTER_SIZES(BM_ForEach_PackedSet)
+REGISTER_SIZES(BM_ForEach_BucketedSet)
+REGISTER_SIZES(BM_Iterate_StdSet)
+REGISTER_SIZES(BM_Iterate_Vector)
+
+BENCHMARK(BM_ContainsBatchScalar_PackedSet)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_ContainsBatchScalar_BucketedSet)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_ContainsMany_PackedSet)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_ContainsMany_BucketedSet)->Arg(8)->Arg(64)->Arg(1024);
+
+BENCHMARK(BM_InsertAtFill_PackedSet)->Arg(50)->Arg(90)->Arg(100);
+BENCHMARK(BM_InsertAtFill_CountedPackedSet)->Arg(50)->Arg(90)->Arg(100);
+
+BENCHMARK_TEMPLATE(BM_Build_BucketedSet, 5);
+BENCHMARK_TEMPLATE(BM_Build_BucketedSet, 32);
+BENCHMARK_TEMPLATE(BM_Build_BucketedSet, 128);
+BENCHMARK_TEMPLATE(BM_Build_BucketedSet, 512);
+
+BENCHMARK_TEMPLATE(BM_ContainsPartitions_BucketedSet, 1);
+BENCHMARK_TEMPLATE(BM_ContainsPartitions_BucketedSet, 2);
+BENCHMARK_TEMPLATE(BM_ContainsPartitions_BucketedSet, 3);
+BENCHMARK_TEMPLATE(BM_ContainsPartitions_BucketedSet, 4);
+
+// Live values out of kChurnCapacity = 128.
+BENCHMARK(BM_ChurnLookup_InPlace)->Arg(16)->Arg(64)->Arg(112);
+BENCHMARK(BM_ChurnLookup_Compact)->Arg(16)->Arg(64)->Arg(112);
+BENCHMARK(BM_Churn_InPlace)->Arg(16)->Arg(64)->Arg(112);
+BENCHMARK(BM_Churn_Compact)->Arg(16)->Arg(64)->Arg(112);
+
+REGISTER_HASH_SIZES(BM_HashContains_PackedHashSet)
+REGISTER_HASH_SIZES(BM_HashContains_PackedSet)
+REGISTER_HASH_SIZES(BM_HashContains_UnorderedSet)
+
+REGISTER_WORKING_SET(BM_WorkingSetContains_PackedSet);
+REGISTER_WORKING_SET(BM_WorkingSetContains_BucketedSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetContains_StdSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetContains_UnorderedSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetContains_Vector);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetContains_SortedVector);
+REGISTER_WORKING_SET(BM_WorkingSetContains_Array);
+
+REGISTER_WORKING_SET(BM_WorkingSetInsert_PackedSet);
+REGISTER_WORKING_SET(BM_WorkingSetInsert_BucketedSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetInsert_StdSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetInsert_UnorderedSet);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetInsert_Vector);
+REGISTER_WORKING_SET_HEAP(BM_WorkingSetInsert_SortedVector);
+REGISTER_WORKING_SET(BM_WorkingSetInsert_Array);
+
+REGISTER_WORKING_SET(BM_WorkingSetContains_PackedSetArena);
+REGISTER_WORKING_SET(BM_WorkingSetContains_PackedSetArenaAligned);
+REGISTER_WORKING_SET(BM_WorkingSetContainsMany_PackedSetArena);
+REGISTER_WORKING_SET(BM_WorkingSetContainsMany_PackedSetArenaAligned);
@@ -0,0 +1,172 @@
+#include <swar/concurrent_bucketed_set.hpp>
+#include <swar/concurrent_packed_set.hpp>
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+using namespace swar;
+
+// One set shared by 1..64 threads, each running a random mix of
+// contains / insert / erase over the values [1, kPool]. state.range(0)
+// is the percentage of writes (split evenly between insert and erase):
+// 5 is the read-heavy mix, 50 the write-heavy one. The set starts with
+// every other pool value, so about half of the lookups hit.
+//
+// Thread 0 builds a fresh set before the timed loop; Google Benchmark
+// holds the other threads at the loop start until it is done.
+
+static constexpr unsigned N = 11;
+static constexpr std::size_t kCapacity = 64;
+static constexpr uint64_t kPool = 96;
+
+// ---------- Containers ----------
+
+using LockFreeSet = ConcurrentPackedSet<N, kCapacity>;
+using LockFreeBucketedSet = ConcurrentBucketedSet<kCapacity>;
+
+/// Baseline: std::unordered_set behind one mutex.
+class MutexSet {
+  public:
+    bool insert(uint64_t v) {
+        std::lock_guard<std::mutex> lock(mu_);
+        return set_.insert(static_cast<uint16_t>(v)).second;
+    }
+    bool erase(uint64_t v) {
+        std::lock_guard<std::mutex> lock(mu_);
+        return set_.erase(static_cast<uint16_t>(v)) == 1;
+    }
+    bool contains(uint64_t v) const {
+        std::lock_guard<std::mutex> lock(mu_);
+        return set_.count(static_cast<uint16_t>(v)) == 1;
+    }
+
+  private:
+    mutable std::mutex mu_;
+    std::unordered_set<uint16_t> set_;
+};
+
+// ---------- Mixed workload ----------
+
+static uint64_t next_random(uint64_t &s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+template <class Set> static std::unique_ptr<Set> g_set;
+
+template <class Set> static void run_mixed(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_set<Set> = std::make_unique<Set>();
+        for (uint64_t v = 1; v <= kPool; v += 2)
+            g_set<Set>->insert(v);
+    }
+    const uint64_t write_pct = static_cast<uint64_t>(state.range(0));
+    uint64_t rng = 0x9e3779b97f4a7c15ull * (state.thread_index() + 1);
+    uint64_t hits = 0;
+    for (auto _ : state) {
+        Set &s = *g_set<Set>;
+        uint64_t r = next_random(rng);
+        uint64_t v = r % kPool + 1;
+        uint64_t op = (r >> 32) % 100;
+        if (op < write_pct) {
+            if (op % 2)
+                benchmark::DoNotOptimize(s.insert(v));
+            else
+                benchmark::DoNotOptimize(s.erase(v));
+        } else {
+            hits += s.contains(v);
+        }
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Mixed_ConcurrentPackedSet(benchmark::State &state) {
+    run_mixed<LockFreeSet>(state);
+}
+
+static void BM_Mixed_MutexUnorderedSet(benchmark::State &state) {
+    run_mixed<MutexSet>(state);
+}
+
+BENCHMARK(BM_Mixed_ConcurrentPackedSet)
+    ->Arg(5)
+    ->Arg(50)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK(BM_Mixed_MutexUnorderedSet)
+    ->Arg(5)
+    ->Arg(50)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// ---------- Partition contention ----------
+//
+// ConcurrentBucketedSet updates one bucket word per CAS, so contention
+// depends on how many threads write the same partition. The same 50%
+// write mix runs over kPool values laid out two ways (state.range(0)):
+//   0  spread: alternating between the halves [1, 1023] and
+//      [1024, 2047], so two partitions share the writes;
+//   1  same half: every value in [1024, 2047], so all threads append to
+//      and erase from one partition's buckets.
+// The mutex baseline runs the same values for reference.
+
+static constexpr uint64_t kHalf = 1024;
+static constexpr uint64_t kContendedWritePct = 50;
+
+static uint64_t contended_value(uint64_t i, bool same_half) {
+    if (same_half)
+        return kHalf + i;
+    return (i % 2) * kHalf + i / 2 + 1;
+}
+
+template <class Set> static void run_contended(benchmark::State &state) {
+    const bool same_half = state.range(0) != 0;
+    if (state.thread_index() == 0) {
+        g_set<Set> = std::make_unique<Set>();
+        for (uint64_t i = 0; i < kPool; i += 2)
+            g_set<Set>->insert(contended_value(i, same_half));
+    }
+    uint64_t rng = 0x9e3779b97f4a7c15ull * (state.thread_index() + 1);
+    uint64_t hits = 0;
+    for (auto _ : state) {
+        Set &s = *g_set<Set>;
+        uint64_t r = next_random(rng);
+        uint64_t v = contended_value(r % kPool, same_half);
+        uint64_t op = (r >> 32) % 100;
+        if (op < kContendedWritePct) {
+            if (op % 2)
+                benchmark::DoNotOptimize(s.insert(v));
+            else
+                benchmark::DoNotOptimize(s.erase(v));
+        } else {
+            hits += s.contains(v);
+        }
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Contended_ConcurrentBucketedSet(benchmark::State &state) {
+    run_contended<LockFreeBucketedSet>(state);
+}
+
+static void BM_Contended_MutexUnorderedSet(benchmark::State &state) {
+    run_contended<MutexSet>(state);
+}
+
+BENCHMARK(BM_Contended_ConcurrentBucketedSet)
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK(BM_Contended_MutexUnorderedSet)
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,334 @@
+#include <swar/packed_vector.hpp>
+#include <swar/packed_word.hpp>
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace swar;
+
+// PackedVector<N> against std::vector<uint16_t> holding the same values.
+// Every benchmark reports:
+//   bits_per_element  storage bits per value (PackedWord<N> wastes
+//                     64 % N bits per word, uint16_t wastes 16 - N)
+//   bytes_per_second  decoded output bytes (uint16_t), i.e. decode GB/s
+// Arg(0) is the element count.
+
+// ---------- Helpers ----------
+
+template <unsigned N>
+static std::vector<uint16_t> make_values(std::size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<uint16_t> out(count);
+    for (auto &v : out)
+        v = static_cast<uint16_t>(rng() & PackedVector<N>::max_value);
+    return out;
+}
+
+template <unsigned N>
+static PackedVector<N> make_packed(const std::vector<uint16_t> &vals) {
+    PackedVector<N> v;
+    v.reserve(vals.size());
+    for (auto x : vals)
+        v.push_back(x);
+    return v;
+}
+
+template <unsigned N>
+static void set_counters(benchmark::State &state, std::size_t bytes,
+                         std::size_t count) {
+    state.counters["N"] = N;
+    state.counters["bits_per_element"] =
+        static_cast<double>(bytes) * 8 / static_cast<double>(count);
+    state.counters["packed_word_bits_per_element"] =
+        64.0 / PackedWord<N>::lanes;
+}
+
+// ---------- Bulk decode ----------
+
+template <unsigned N> static void BM_Decode_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    std::vector<uint16_t> out(n);
+    for (auto _ : state) {
+        v.decode(0, n, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(n) * 2);
+}
+
+// The scalar kernel, whatever the translation unit's ISA.
+template <unsigned N>
+static void BM_DecodeScalar_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    std::vector<uint16_t> out(n);
+    for (auto _ : state) {
+        unpack_groups_scalar<N>(v.bytes(), n / unpack_group, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(n) * 2);
+}
+
+// Baseline: the values already sit unpacked, decoding is a copy.
+template <unsigned N> static void BM_Decode_Vector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_values<N>(n);
+    std::vector<uint16_t> out(n);
+    for (auto _ : state) {
+        std::memcpy(out.data(), v.data(), n * sizeof(uint16_t));
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters<N>(state, n * sizeof(uint16_t), n);
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(n) * 2);
+}
+
+// ---------- Random access ----------
+
+static std::vector<std::size_t> make_indices(std::size_t n) {
+    std::mt19937_64 rng(7);
+    std::vector<std::size_t> idx(1024);
+    for (auto &i : idx)
+        i = rng() % n;
+    return idx;
+}
+
+template <unsigned N> static void BM_Get_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    auto idx = make_indices(n);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (auto i : idx)
+            sum += v.get(i);
+        benchmark::DoNotOptimize(sum);
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(idx.size()));
+}
+
+template <unsigned N> static void BM_Get_Vector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_values<N>(n);
+    auto idx = make_indices(n);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (auto i : idx)
+            sum += v[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    set_counters<N>(state, n * sizeof(uint16_t), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(idx.size()));
+}
+
+template <unsigned N> static void BM_Set_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    auto idx = make_indices(n);
+    for (auto _ : state) {
+        for (auto i : idx)
+            v.set(i, i & PackedVector<N>::max_value);
+        benchmark::DoNotOptimize(v.bytes());
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(idx.size()));
+}
+
+// ---------- Append ----------
+
+template <unsigned N>
+static void BM_PushBack_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto vals = make_values<N>(n);
+    for (auto _ : state) {
+        PackedVector<N> v;
+        for (auto x : vals)
+            v.push_back(x);
+        benchmark::DoNotOptimize(v.bytes());
+    }
+    set_counters<N>(state, make_packed<N>(vals).memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N> static void BM_PushBack_Vector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto vals = make_values<N>(n);
+    for (auto _ : state) {
+        std::vector<uint16_t> v;
+        for (auto x : vals)
+            v.push_back(x);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_counters<N>(state, n * sizeof(uint16_t), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+// ---------- Predicates without decoding ----------
+// count_eq / find_first (needle absent, so a full scan) / filter_lt over
+// the packed stream, against decoding 4K-value chunks to uint16_t and
+// comparing, and against a plain std::vector<uint16_t>. items_per_second
+// is values scanned.
+
+static constexpr std::size_t kChunk = 4096;
+
+template <unsigned N> static uint64_t scan_needle() {
+    return PackedVector<N>::max_value / 3;
+}
+
+template <unsigned N>
+static void BM_CountEq_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    for (auto _ : state) {
+        auto c = v.count_eq(scan_needle<N>());
+        benchmark::DoNotOptimize(c);
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N>
+static void BM_CountEq_DecodeThenCompare(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    std::vector<uint16_t> buf(kChunk);
+    for (auto _ : state) {
+        std::size_t c = 0;
+        for (std::size_t i = 0; i < n; i += kChunk) {
+            std::size_t len = std::min(kChunk, n - i);
+            v.decode(i, i + len, buf.data());
+            for (std::size_t j = 0; j < len; ++j)
+                c += buf[j] == scan_needle<N>();
+        }
+        benchmark::DoNotOptimize(c);
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N> static void BM_CountEq_Vector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_values<N>(n);
+    for (auto _ : state) {
+        auto c = std::count(v.begin(), v.end(), uint16_t(scan_needle<N>()));
+        benchmark::DoNotOptimize(c);
+    }
+    set_counters<N>(state, n * sizeof(uint16_t), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+// Needle absent: every value is scanned.
+template <unsigned N> static std::vector<uint16_t> values_without_needle(std::size_t n) {
+    auto vals = make_values<N>(n);
+    for (auto &x : vals) {
+        if (x == scan_needle<N>())
+            x = 0;
+    }
+    return vals;
+}
+
+template <unsigned N>
+static void BM_FindFirst_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(values_without_needle<N>(n));
+    for (auto _ : state) {
+        auto i = v.find_first(scan_needle<N>());
+        benchmark::DoNotOptimize(i);
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N>
+static void BM_FindFirst_DecodeThenCompare(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(values_without_needle<N>(n));
+    std::vector<uint16_t> buf(kChunk);
+    for (auto _ : state) {
+        std::size_t found = n;
+        for (std::size_t i = 0; i < n && found == n; i += kChunk) {
+            std::size_t len = std::min(kChunk, n - i);
+            v.decode(i, i + len, buf.data());
+            auto it = std::find(buf.begin(), buf.begin() + len,
+                                uint16_t(scan_needle<N>()));
+            if (it != buf.begin() + len)
+                found = i + static_cast<std::size_t>(it - buf.begin());
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N>
+static void BM_FilterLt_PackedVector(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    std::vector<uint64_t> bitmap(v.bitmap_words());
+    for (auto _ : state) {
+        auto c = v.filter_lt(scan_needle<N>(), bitmap.data());
+        benchmark::DoNotOptimize(c);
+        benchmark::ClobberMemory();
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template <unsigned N>
+static void BM_FilterLt_DecodeThenCompare(benchmark::State &state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    auto v = make_packed<N>(make_values<N>(n));
+    std::vector<uint64_t> bitmap((n + 63) / 64);
+    std::vector<uint16_t> buf(kChunk);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; i += kChunk) {
+            std::size_t len = std::min(kChunk, n - i);
+            v.decode(i, i + len, buf.data());
+            // kChunk is a multiple of 64, so chunks start on a bitmap word.
+            for (std::size_t j = 0; j < len; j += 64) {
+                uint64_t bits = 0;
+                for (std::size_t k = 0; k < 64 && j + k < len; ++k)
+                    bits |= uint64_t(buf[j + k] < scan_needle<N>()) << k;
+                bitmap[(i + j) / 64] = bits;
+            }
+        }
+        benchmark::DoNotOptimize(bitmap.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters<N>(state, v.memory_bytes(), n);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+// ============================================================
+// Register all benchmarks
+// ============================================================
+
+// 64K values stay cache resident; 16M values stream from memory.
+#define REGISTER_ALL(N)                                                        \
+    BENCHMARK(BM_Decode_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);          \
+    BENCHMARK(BM_DecodeScalar_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);    \
+    BENCHMARK(BM_Decode_Vector<N>)->Arg(1 << 16)->Arg(1 << 24);                \
+    BENCHMARK(BM_Get_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);             \
+    BENCHMARK(BM_Get_Vector<N>)->Arg(1 << 16)->Arg(1 << 24);                   \
+    BENCHMARK(BM_Set_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);             \
+    BENCHMARK(BM_PushBack_PackedVector<N>)->Arg(1 << 16);                      \
+    BENCHMARK(BM_PushBack_Vector<N>)->Arg(1 << 16);                            \
+    BENCHMARK(BM_CountEq_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);         \
+    BENCHMARK(BM_CountEq_DecodeThenCompare<N>)->Arg(1 << 16)->Arg(1 << 24);    \
+    BENCHMARK(BM_CountEq_Vector<N>)->Arg(1 << 16)->Arg(1 << 24);               \
+    BENCHMARK(BM_FindFirst_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);       \
+    BENCHMARK(BM_FindFirst_DecodeThenCompare<N>)->Arg(1 << 16)->Arg(1 << 24);  \
+    BENCHMARK(BM_FilterLt_PackedVector<N>)->Arg(1 << 16)->Arg(1 << 24);        \
+    BENCHMARK(BM_FilterLt_DecodeThenCompare<N>)->Arg(1 << 16)->Arg(1 << 24);
+
+REGISTER_ALL(5)
+REGISTER_ALL(11)
+REGISTER_ALL(12)
+REGISTER_ALL(16)
@@ -1,8 +1,12 @@
+#include <swar/dispatch.hpp>
 #include <swar/packed_set.hpp>
 #include <swar/packed_word.hpp>
+#include <swar/word_scan.hpp>
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <random>
+#include <vector>
 
 using namespace swar;
 
@@ -44,6 +48,55 @@ template <unsigned N> static void BM_Extract(benchmark::State &state) {
     }
 }
 
+// ---------- Min / Max ----------
+// Cycle through a few words so the reduction cannot be hoisted. BM_MinLoop
+// is the lane-by-lane get() loop the SWAR reduction replaced.
+
+static constexpr std::size_t kMinMaxWords = 64;
+
+template <unsigned N>
+static std::vector<PackedWord<N>> make_min_max_words() {
+    std::mt19937_64 rng(42);
+    std::vector<PackedWord<N>> words;
+    for (std::size_t i = 0; i < kMinMaxWords; ++i)
+        words.push_back(make_full_word<N>(rng));
+    return words;
+}
+
+template <unsigned N> static void BM_MinLoop(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto words = make_min_max_words<N>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const W &w = words[i];
+        uint64_t m = w.get(0);
+        for (unsigned lane = 1; lane < W::lanes; ++lane)
+            m = std::min(m, w.get(lane));
+        benchmark::DoNotOptimize(m);
+        i = (i + 1) % kMinMaxWords;
+    }
+}
+
+template <unsigned N> static void BM_Min(benchmark::State &state) {
+    auto words = make_min_max_words<N>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto m = words[i].min();
+        benchmark::DoNotOptimize(m);
+        i = (i + 1) % kMinMaxWords;
+    }
+}
+
+template <unsigned N> static void BM_Max(benchmark::State &state) {
+    auto words = make_min_max_words<N>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto m = words[i].max();
+        benchmark::DoNotOptimize(m);
+        i = (i + 1) % kMinMaxWords;
+    }
+}
+
 // ---------- Contains (hit) ----------
 
 template <unsigned N> static void BM_ContainsHit(benchmark::State &state) {
@@ -111,16 +164,311 @@ template <unsigned N> static void BM_SetContains(benchmark::State &state) {
     }
 }
 
+// ---------- PackedSet count_in_range ----------
+// The loop variant extracts every lane, for comparison with the
+// comparison-mask version.
+
+template <unsigned N>
+static PackedSet<N, 64> make_range_set() {
+    using W = PackedWord<N>;
+    PackedSet<N, 64> s;
+    uint64_t cap = std::min<uint64_t>(W::max_safe_value, 64);
+    for (uint64_t v = 1; v <= cap; ++v)
+        s.insert(v);
+    return s;
+}
+
+template <unsigned N> static void BM_SetCountInRange(benchmark::State &state) {
+    auto s = make_range_set<N>();
+    uint64_t hi = PackedWord<N>::max_safe_value / 2;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        auto n = s.count_in_range(hi / 2, hi);
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+template <unsigned N>
+static void BM_SetCountInRangeLoop(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto s = make_range_set<N>();
+    uint64_t hi = W::max_safe_value / 2;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s);
+        std::size_t n = 0;
+        for (const auto &w : s.words()) {
+            for (unsigned i = 0; i < W::lanes; ++i) {
+                uint64_t v = w.get(i);
+                n += v != 0 && v >= hi / 2 && v <= hi;
+            }
+        }
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+// ---------- Word scan: scalar vs compile-time vector backend ----------
+// Capacity comes from state.range(0); the needle is absent so every word
+// is scanned. The vector variant falls back to scalar when the binary is
+// built without SWAR_SIMD.
+
+template <unsigned N>
+static std::vector<PackedWord<N>> make_scan_words(std::size_t capacity) {
+    using W = PackedWord<N>;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> dist(1, W::max_safe_value - 1);
+    std::vector<W> words((capacity + W::lanes - 1) / W::lanes);
+    for (auto &w : words)
+        for (unsigned i = 0; i < W::lanes; ++i)
+            w = w.set(i, dist(rng));
+    return words;
+}
+
+template <unsigned N> static void BM_ScanScalar(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto words = make_scan_words<N>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto wi = scan_first_word_scalar(words.data(), 0, words.size(),
+                                         W::max_safe_value);
+        benchmark::DoNotOptimize(wi);
+    }
+    state.counters["words"] = static_cast<double>(words.size());
+}
+
+template <unsigned N> static void BM_ScanVector(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto words = make_scan_words<N>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto wi = scan_first_word(words.data(), words.size(),
+                                  W::max_safe_value);
+        benchmark::DoNotOptimize(wi);
+    }
+    state.counters["words"] = static_cast<double>(words.size());
+    state.counters["backend"] = static_cast<double>(scan_backend);
+}
+
+// ---------- Runtime dispatch: force each tier ----------
+// Args: (backend, capacity). Backend follows ScanBackend: 0=scalar,
+// 1=sse4.2, 2=avx2, 3=avx512. Tiers the CPU lacks are skipped.
+// BM_DispatchInline is the inlined scalar loop at the same capacity, so
+// the 5-element rows show the cost of the indirect call itself.
+
+static void BM_DispatchScan(benchmark::State &state) {
+    using W = PackedWord<11>;
+    auto backend = static_cast<ScanBackend>(state.range(0));
+    if (!force_word_scan_backend<11>(backend)) {
+        state.SkipWithError("backend not supported by this CPU");
+        return;
+    }
+    auto words = make_scan_words<11>(static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state) {
+        auto wi = scan_first_word_dispatch(words.data(), words.size(),
+                                           W::max_safe_value);
+        benchmark::DoNotOptimize(wi);
+    }
+    force_word_scan_backend<11>(cpu_scan_backend());
+    state.counters["words"] = static_cast<double>(words.size());
+}
+
+static void BM_DispatchInline(benchmark::State &state) {
+    using W = PackedWord<11>;
+    auto words = make_scan_words<11>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.data());
+        auto wi = scan_first_word_scalar(words.data(), 0, words.size(),
+                                         W::max_safe_value);
+        benchmark::DoNotOptimize(wi);
+    }
+    state.counters["words"] = static_cast<double>(words.size());
+}
+
+BENCHMARK(BM_DispatchScan)->ArgsProduct({{0, 1, 2, 3}, {5, 64, 1024}});
+BENCHMARK(BM_DispatchInline)->Arg(5)->Arg(64)->Arg(1024);
+
+// ---------- Lane compaction: PEXT/PDEP vs lane loop ----------
+// Cycle through kMinMaxWords words with random half-full lane masks.
+// The plain variants use BMI2 when the binary is built with it (the
+// "bmi2" counter); the Scalar variants always take the lane loop.
+// BM_UnpackAllGet is the get() loop unpack_all replaces.
+
+template <unsigned N> static std::vector<uint64_t> make_lane_masks() {
+    using W = PackedWord<N>;
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> masks(kMinMaxWords);
+    for (auto &m : masks)
+        m = rng() & W::high_bits;
+    return masks;
+}
+
+#if defined(__BMI2__)
+constexpr double kBmi2 = 1;
+#else
+constexpr double kBmi2 = 0;
+#endif
+
+template <unsigned N, bool Scalar>
+static void BM_Compress(benchmark::State &state) {
+    auto words = make_min_max_words<N>();
+    auto masks = make_lane_masks<N>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto c = Scalar ? words[i].compress_scalar(masks[i])
+                        : words[i].compress(masks[i]);
+        benchmark::DoNotOptimize(c);
+        i = (i + 1) % kMinMaxWords;
+    }
+    state.counters["bmi2"] = Scalar ? 0 : kBmi2;
+}
+
+template <unsigned N, bool Scalar>
+static void BM_Expand(benchmark::State &state) {
+    auto words = make_min_max_words<N>();
+    auto masks = make_lane_masks<N>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto c = Scalar ? words[i].expand_scalar(masks[i])
+                        : words[i].expand(masks[i]);
+        benchmark::DoNotOptimize(c);
+        i = (i + 1) % kMinMaxWords;
+    }
+    state.counters["bmi2"] = Scalar ? 0 : kBmi2;
+}
+
+template <unsigned N, bool Scalar>
+static void BM_UnpackAll(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto words = make_min_max_words<N>();
+    uint16_t out[W::lanes];
+    std::size_t i = 0;
+    for (auto _ : state) {
+        if (Scalar)
+            words[i].unpack_all_scalar(out);
+        else
+            words[i].unpack_all(out);
+        benchmark::DoNotOptimize(out);
+        benchmark::ClobberMemory();
+        i = (i + 1) % kMinMaxWords;
+    }
+    state.SetItemsProcessed(state.iterations() * W::lanes);
+    state.counters["bmi2"] = Scalar ? 0 : kBmi2;
+}
+
+template <unsigned N> static void BM_UnpackAllGet(benchmark::State &state) {
+    using W = PackedWord<N>;
+    auto words = make_min_max_words<N>();
+    uint16_t out[W::lanes];
+    std::size_t i = 0;
+    for (auto _ : state) {
+        for (unsigned k = 0; k < W::lanes; ++k)
+            out[k] = static_cast<uint16_t>(words[i].get(k));
+        benchmark::DoNotOptimize(out);
+        benchmark::ClobberMemory();
+        i = (i + 1) % kMinMaxWords;
+    }
+    state.SetItemsProcessed(state.iterations() * W::lanes);
+}
+
+#define REGISTER_COMPACTION(N)                                                 \
+    BENCHMARK_TEMPLATE(BM_Compress, N, false);                                 \
+    BENCHMARK_TEMPLATE(BM_Compress, N, true);                                  \
+    BENCHMARK_TEMPLATE(BM_Expand, N, false);                                   \
+    BENCHMARK_TEMPLATE(BM_Expand, N, true);                                    \
+    BENCHMARK_TEMPLATE(BM_UnpackAll, N, false);                                \
+    BENCHMARK_TEMPLATE(BM_UnpackAll, N, true);                                 \
+    BENCHMARK(BM_UnpackAllGet<N>);
+
+// ---------- Zero-test policy: guarded vs exact ----------
+// The same word-array workloads under each ZeroTest. Values are drawn
+// from [1, max_safe_value] of the policy, so ExactZero rows use the full
+// N-bit range and GuardedZero rows one bit less.
+
+constexpr std::size_t kModeWords = 64;
+
+template <unsigned N, class Z>
+static std::vector<PackedWord<N, Z>> make_mode_words() {
+    using W = PackedWord<N, Z>;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> dist(1, W::max_safe_value);
+    std::vector<W> words(kModeWords);
+    for (auto &w : words)
+        for (unsigned i = 0; i < W::lanes; ++i)
+            w = w.set(i, dist(rng));
+    return words;
+}
+
+template <unsigned N, class Z>
+static void BM_CountEqMode(benchmark::State &state) {
+    using W = PackedWord<N, Z>;
+    auto words = make_mode_words<N, Z>();
+    uint64_t v = words[kModeWords / 2].get(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.data());
+        unsigned n = 0;
+        for (const auto &w : words)
+            n += w.count_eq(v);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(kModeWords * W::lanes));
+}
+
+template <unsigned N, class Z> static void BM_FindMode(benchmark::State &state) {
+    using W = PackedWord<N, Z>;
+    auto words = make_mode_words<N, Z>();
+    uint64_t v = 0; // absent: every word is tested
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.data());
+        std::size_t wi = 0;
+        while (wi < kModeWords && words[wi].find(v) < 0)
+            ++wi;
+        benchmark::DoNotOptimize(wi);
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(kModeWords * W::lanes));
+}
+
+template <unsigned N, class Z>
+static void BM_LessThanMode(benchmark::State &state) {
+    using W = PackedWord<N, Z>;
+    auto words = make_mode_words<N, Z>();
+    uint64_t v = W::max_safe_value / 2;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.data());
+        unsigned n = 0;
+        for (const auto &w : words)
+            n += W::count_lanes(w.less_than_mask(v));
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(kModeWords * W::lanes));
+}
+
+#define REGISTER_MODES(N)                                                      \
+    BENCHMARK_TEMPLATE(BM_CountEqMode, N, GuardedZero);                        \
+    BENCHMARK_TEMPLATE(BM_CountEqMode, N, ExactZero);                          \
+    BENCHMARK_TEMPLATE(BM_FindMode, N, GuardedZero);                           \
+    BENCHMARK_TEMPLATE(BM_FindMode, N, ExactZero);                             \
+    BENCHMARK_TEMPLATE(BM_LessThanMode, N, GuardedZero);                       \
+    BENCHMARK_TEMPLATE(BM_LessThanMode, N, ExactZero);
+
 // ---------- Register benchmarks for N = 5..14 ----------
 
 #define REGISTER_ALL(N)                                                        \
     BENCHMARK(BM_Broadcast<N>);                                                \
     BENCHMARK(BM_Extract<N>);                                                  \
+    BENCHMARK(BM_MinLoop<N>);                                                  \
+    BENCHMARK(BM_Min<N>);                                                      \
+    BENCHMARK(BM_Max<N>);                                                      \
     BENCHMARK(BM_ContainsHit<N>);                                              \
     BENCHMARK(BM_ContainsMiss<N>);                                             \
     BENCHMARK(BM_Find<N>);                                                     \
     BENCHMARK(BM_SetInsert<N>);                                                \
-    BENCHMARK(BM_SetContains<N>);
+    BENCHMARK(BM_SetContains<N>);                                              \
+    BENCHMARK(BM_SetCountInRange<N>);                                          \
+    BENCHMARK(BM_SetCountInRangeLoop<N>);                                      \
+    BENCHMARK(BM_ScanScalar<N>)->Arg(64)->Arg(256)->Arg(1024);                 \
+    BENCHMARK(BM_ScanVector<N>)->Arg(64)->Arg(256)->Arg(1024);                 \
+    REGISTER_MODES(N)                                                          \
+    REGISTER_COMPACTION(N)
 
 REGISTER_ALL(5)
 REGISTER_ALL(6)
@@ -0,0 +1,96 @@
+#include <swar/sharded_packed_set.hpp>
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace swar;
+
+// Ingest throughput: kKeys random 16-bit keys (about 98% of the key
+// space ends up present) into an emptied set, per iteration. Items are
+// input keys, so items_per_second is ingest throughput whatever the
+// thread count.
+//
+// BM_Ingest_Sharded runs one writer per benchmark thread, from 1 thread
+// to every core: thread t clears and fills its own shard run, scanning
+// the whole stream and keeping the keys routed to it. Thread 0 builds
+// the set before the timed loop; Google Benchmark holds the other
+// threads at the loop start until it is done.
+
+static constexpr std::size_t kKeys = std::size_t(1) << 18;
+
+using Sharded = ShardedPackedSet<>;
+
+static const std::vector<uint16_t> &input_keys() {
+    static const std::vector<uint16_t> keys = [] {
+        std::vector<uint16_t> k(kKeys);
+        std::mt19937 rng(42);
+        for (auto &x : k)
+            x = static_cast<uint16_t>(rng());
+        return k;
+    }();
+    return keys;
+}
+
+/// Thread counts 1, 2, 4, ... up to and including every core.
+static void up_to_all_cores(benchmark::internal::Benchmark *b) {
+    int cores = std::max(1, static_cast<int>(
+                                std::thread::hardware_concurrency()));
+    for (int t = 1; t < cores; t *= 2)
+        b->Threads(t);
+    b->Threads(cores);
+}
+
+// ---------- Single-threaded references ----------
+
+static void BM_Ingest_SerialSharded(benchmark::State &state) {
+    const auto &keys = input_keys();
+    Sharded s;
+    for (auto _ : state) {
+        s = Sharded();
+        for (uint16_t k : keys)
+            benchmark::DoNotOptimize(s.insert(k));
+    }
+    benchmark::DoNotOptimize(s.count());
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+
+static void BM_Ingest_UnorderedSet(benchmark::State &state) {
+    const auto &keys = input_keys();
+    for (auto _ : state) {
+        std::unordered_set<uint16_t> s;
+        for (uint16_t k : keys)
+            benchmark::DoNotOptimize(s.insert(k));
+        benchmark::DoNotOptimize(s.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+
+BENCHMARK(BM_Ingest_SerialSharded);
+BENCHMARK(BM_Ingest_UnorderedSet);
+
+// ---------- Thread-affine ingest ----------
+
+static std::unique_ptr<Sharded> g_sharded;
+
+static void BM_Ingest_Sharded(benchmark::State &state) {
+    const auto &keys = input_keys();
+    if (state.thread_index() == 0)
+        g_sharded = std::make_unique<Sharded>();
+    const auto t = static_cast<std::size_t>(state.thread_index());
+    const auto writers = static_cast<std::size_t>(state.threads());
+    for (auto _ : state) {
+        auto w = g_sharded->writer(t, writers);
+        w.clear();
+        benchmark::DoNotOptimize(w.ingest(keys.data(), keys.size()));
+    }
+    // Each thread accounts for its share of the stream.
+    state.SetItemsProcessed(state.iterations() * kKeys / writers);
+}
+
+BENCHMARK(BM_Ingest_Sharded)->Apply(up_to_all_cores)->UseRealTime();
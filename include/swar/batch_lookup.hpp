@@ -0,0 +1,196 @@
+#pragma once
+
+#include "packed_set.hpp"
+#include "packed_set_arena.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace swar {
+
+// ----- batched lookups across many sets -----
+//
+// out[i] = "set i contains values[i]" for a batch of (set, value) pairs
+// whose sets are scattered over more memory than the caches hold, so a
+// plain loop stalls on one miss per set. Sets come either as an array of
+// PackedSet pointers or as PackedSetArena handles. Two schedules hide
+// the misses:
+//
+//   contains_batch       group prefetch: every line of set i +
+//                        batch_prefetch_distance is prefetched before
+//                        set i is tested, so that many misses overlap.
+//   contains_batch_amac  asynchronous memory access chaining: up to
+//                        batch_amac_width lookups are in flight, each a
+//                        small state machine that tests one cache line
+//                        and then prefetches its next line and yields.
+//                        A lookup stops at the line holding its value,
+//                        so hits in multi-line sets skip later lines.
+//
+// Both test lanes with the set's PackedWord zero test: each line's words
+// are XORed with the broadcast needle and their zero-lane masks ORed, so
+// there is one branch per line rather than per word.
+
+/// How many lookups ahead contains_batch prefetches.
+inline constexpr std::size_t batch_prefetch_distance = 16;
+
+/// Lookups contains_batch_amac keeps in flight.
+inline constexpr std::size_t batch_amac_width = 16;
+
+namespace detail {
+
+inline constexpr std::size_t batch_line_bytes =
+    CacheLineAllocator<char>::alignment;
+
+/// Words from w to the end of its cache line.
+template <class Word>
+inline std::size_t words_to_line_end(const Word *w) noexcept {
+    auto addr = reinterpret_cast<uintptr_t>(w);
+    return (batch_line_bytes - addr % batch_line_bytes) / sizeof(Word);
+}
+
+/// Prefetch every line of words [w, w + n).
+template <class Word>
+inline void prefetch_words(const Word *w, std::size_t n) noexcept {
+    auto first = reinterpret_cast<uintptr_t>(w);
+    auto last = reinterpret_cast<uintptr_t>(w + n - 1);
+    for (uintptr_t a = first & ~uintptr_t(batch_line_bytes - 1); a <= last;
+         a += batch_line_bytes)
+        __builtin_prefetch(reinterpret_cast<const void *>(a));
+}
+
+/// OR of the zero-lane masks of words [w, w + n) XOR needle: nonzero iff
+/// one of them holds the broadcast value.
+template <class Word>
+inline uint64_t match_words(const Word *w, std::size_t n,
+                            uint64_t needle) noexcept {
+    uint64_t m = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        m |= Word(w[i].raw() ^ needle).zero_lanes_mask();
+    return m;
+}
+
+/// Group-prefetch schedule over sets of Words words; words_of(i) is the
+/// first word of lookup i's set.
+template <class Word, std::size_t Words, class WordsOf>
+void contains_batch_prefetch(WordsOf words_of, const uint64_t *values,
+                             std::size_t count, bool *out) {
+    std::size_t ahead = std::min(batch_prefetch_distance, count);
+    for (std::size_t i = 0; i < ahead; ++i)
+        prefetch_words(words_of(i), Words);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i + batch_prefetch_distance < count)
+            prefetch_words(words_of(i + batch_prefetch_distance), Words);
+        assert(values[i] >= 1 && values[i] <= Word::max_safe_value);
+        out[i] = match_words(words_of(i), Words,
+                             Word::broadcast(values[i]).raw()) != 0;
+    }
+}
+
+/// AMAC schedule over sets of Words words; words_of(i) as above.
+template <class Word, std::size_t Words, class WordsOf>
+void contains_batch_amac(WordsOf words_of, const uint64_t *values,
+                         std::size_t count, bool *out) {
+    struct Lookup {
+        const Word *next; // first word of the line to test next
+        std::size_t left; // words of the set from next on
+        uint64_t needle;  // broadcast value
+        std::size_t i;    // index into values / out
+    };
+    constexpr std::size_t line_words =
+        std::min(Words, batch_line_bytes / sizeof(Word));
+    std::array<Lookup, batch_amac_width> slots;
+    std::size_t issued = 0;
+
+    auto start = [&](Lookup &s) {
+        assert(values[issued] >= 1 &&
+               values[issued] <= Word::max_safe_value);
+        s = {words_of(issued), Words, Word::broadcast(values[issued]).raw(),
+             issued};
+        __builtin_prefetch(s.next);
+        ++issued;
+    };
+
+    std::size_t active = std::min(batch_amac_width, count);
+    for (std::size_t k = 0; k < active; ++k)
+        start(slots[k]);
+
+    // Slots [0, active) are live; a finished slot takes the next lookup,
+    // or the last live slot once the batch is fully issued.
+    while (active != 0) {
+        for (std::size_t k = 0; k < active;) {
+            Lookup &s = slots[k];
+            std::size_t n = std::min(s.left, words_to_line_end(s.next));
+            // A whole line takes the fixed-count path, which unrolls;
+            // only the unaligned head or tail of a set pays for a
+            // variable-length loop.
+            bool hit = (n == line_words
+                            ? match_words(s.next, line_words, s.needle)
+                            : match_words(s.next, n, s.needle)) != 0;
+            s.next += n;
+            s.left -= n;
+            if (s.left != 0 && !hit) {
+                __builtin_prefetch(s.next);
+                ++k;
+                continue;
+            }
+            out[s.i] = hit;
+            if (issued < count) {
+                start(s);
+                ++k;
+            } else {
+                s = slots[--active];
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/// out[i] = sets[i]->contains(values[i]) for i in [0, count), with group
+/// prefetch.
+template <class Set>
+void contains_batch(const Set *const *sets, const uint64_t *values,
+                    std::size_t count, bool *out) {
+    detail::contains_batch_prefetch<typename Set::Word, Set::num_words>(
+        [sets](std::size_t i) { return sets[i]->words().data(); }, values,
+        count, out);
+}
+
+/// out[i] = sets[i]->contains(values[i]) for i in [0, count), with AMAC.
+template <class Set>
+void contains_batch_amac(const Set *const *sets, const uint64_t *values,
+                         std::size_t count, bool *out) {
+    detail::contains_batch_amac<typename Set::Word, Set::num_words>(
+        [sets](std::size_t i) { return sets[i]->words().data(); }, values,
+        count, out);
+}
+
+/// out[i] = arena.contains(handles[i], values[i]), with group prefetch
+/// (the same schedule as PackedSetArena::contains_many).
+template <unsigned N, std::size_t Capacity, bool AlignStride>
+void contains_batch(
+    const PackedSetArena<N, Capacity, AlignStride> &arena,
+    const typename PackedSetArena<N, Capacity, AlignStride>::handle *handles,
+    const uint64_t *values, std::size_t count, bool *out) {
+    using Arena = PackedSetArena<N, Capacity, AlignStride>;
+    detail::contains_batch_prefetch<typename Arena::Word,
+                                    Arena::words_per_set>(
+        [&](std::size_t i) { return arena.set_words(handles[i]); }, values,
+        count, out);
+}
+
+/// out[i] = arena.contains(handles[i], values[i]), with AMAC.
+template <unsigned N, std::size_t Capacity, bool AlignStride>
+void contains_batch_amac(
+    const PackedSetArena<N, Capacity, AlignStride> &arena,
+    const typename PackedSetArena<N, Capacity, AlignStride>::handle *handles,
+    const uint64_t *values, std::size_t count, bool *out) {
+    using Arena = PackedSetArena<N, Capacity, AlignStride>;
+    detail::contains_batch_amac<typename Arena::Word, Arena::words_per_set>(
+        [&](std::size_t i) { return arena.set_words(handles[i]); }, values,
+        count, out);
+}
+
+} // namespace swar
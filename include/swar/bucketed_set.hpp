@@ -1,140 +1,408 @@
 #pragma once
 
+#include "dispatch.hpp"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <type_traits>
 
 namespace swar {
 
-/// A fixed-capacity set of 11-bit integers, stored using MSB-shared bucket
-/// packing. Each uint64_t bucket holds 3 × 11-bit lanes (10 data + 1 guard)
-/// with a 2-bit lane count in bits 34:33.
+/// Largest lane count L with L lanes of lane_bits plus an L-valued count
+/// field fitting in one uint64_t.
+constexpr unsigned max_bucket_lanes(unsigned lane_bits) {
+    unsigned lanes = 0;
+    for (unsigned l = 1; l * lane_bits < 64; ++l) {
+        unsigned count_bits = 0;
+        while ((1u << count_bits) <= l)
+            ++count_bits;
+        if (l * lane_bits + count_bits <= 64)
+            lanes = l;
+    }
+    return lanes;
+}
+
+/// A fixed-capacity set of ValueBits-bit integers, stored using
+/// MSB-partitioned bucket packing.
 ///
-/// Bucket layout (uint64_t):
-///   [...unused...][count:2][G2][val2:10][G1][val1:10][G0][val0:10]
-///      63..35       34:33   32  31..22   21  20..11   10   9..0
+/// The top PartitionBits bits of a value select one of 2^PartitionBits
+/// partitions; only the remaining stored_bits = ValueBits - PartitionBits
+/// are kept, in a lane of stored_bits + 1 bits (the extra top bit is the
+/// haszero guard). Lookups scan a single partition, and every partition
+/// bit shrinks the lane, so more lanes fit per bucket.
 ///
-/// Guard bits (G0=bit10, G1=bit21, G2=bit32) enable the haszero SWAR trick
-/// for parallel 3-lane matching in a single operation.
+/// Bucket layout (uint64_t), L = lanes_per_bucket, B = lane_bits:
+///   [...unused...][count][G(L-1)][val(L-1)] ... [G0][val0]
+///                  ^ bit L*B                     ^ bit 0
 ///
-/// count (bits 34:33): number of occupied lanes (0-3).
+/// count: number of occupied lanes, lanes [0, count) hold values.
 ///
-/// Values are split by MSB (bit 10): lo_buckets_ stores values [1,1023],
-/// hi_buckets_ stores values [1024,2047]. The lower 10 bits are stored
-/// in the lane data bits; guard bits are always 0 for valid data.
-template <std::size_t Capacity>
-class BucketedSet {
+/// Every partition has room for Capacity values, so any value
+/// distribution fits. LanesPerBucket defaults to the densest layout.
+template <unsigned ValueBits, unsigned PartitionBits, std::size_t Capacity,
+          unsigned LanesPerBucket =
+              max_bucket_lanes(ValueBits - PartitionBits + 1)>
+class BasicBucketedSet {
     static_assert(Capacity > 0, "Capacity must be > 0");
+    static_assert(ValueBits >= 2 && ValueBits <= 32,
+                  "ValueBits must be in [2,32]");
+    static_assert(PartitionBits >= 1 && PartitionBits < ValueBits &&
+                      PartitionBits <= 8,
+                  "PartitionBits must be in [1, min(8, ValueBits - 1)]");
 
   public:
-    static constexpr unsigned value_bits = 11;
-    static constexpr uint16_t max_value = (1u << value_bits) - 1; // 2047
-    static constexpr unsigned lanes_per_bucket = 3;
-    static constexpr std::size_t buckets_per_half =
+    using value_type =
+        std::conditional_t<(ValueBits <= 16), uint16_t, uint32_t>;
+
+    static constexpr unsigned value_bits = ValueBits;
+    static constexpr value_type max_value =
+        static_cast<value_type>((uint64_t(1) << value_bits) - 1);
+    static constexpr unsigned partition_bits = PartitionBits;
+    static constexpr std::size_t partitions = std::size_t(1) << PartitionBits;
+    static constexpr unsigned stored_bits = ValueBits - PartitionBits;
+    static constexpr unsigned lane_bits = stored_bits + 1;
+    static constexpr unsigned lanes_per_bucket = LanesPerBucket;
+    static constexpr std::size_t buckets_per_partition =
         (Capacity + lanes_per_bucket - 1) / lanes_per_bucket;
     static constexpr std::size_t capacity = Capacity;
 
-    constexpr BucketedSet() noexcept : lo_buckets_{}, hi_buckets_{} {}
+    static_assert(lanes_per_bucket >= 1 &&
+                      lanes_per_bucket <= max_bucket_lanes(lane_bits),
+                  "LanesPerBucket lanes and their count must fit in 64 bits");
+
+    constexpr BasicBucketedSet() noexcept : parts_{}, cursors_{} {}
 
-    bool insert(uint16_t v) {
+    /// One pass over the partition for the duplicate check; the free lane
+    /// comes from the partition's cursor. The cursor only moves (forward,
+    /// to the next non-full bucket) when this insert fills its bucket. A
+    /// full partition is rejected without scanning.
+    bool insert(value_type v) {
         assert(v >= 1 && v <= max_value);
-        uint32_t msb = v >> 10;
-        uint16_t lo = v & 0x3FF;
-        auto &buckets = msb ? hi_buckets_ : lo_buckets_;
+        std::size_t p = partition_of(v);
+        value_type lo = stored_of(v);
+        const auto &buckets = parts_[p];
 
-        // Check for duplicate
+        if (cursors_[p] == buckets_per_partition)
+            return false; // full
         for (const auto &b : buckets) {
             if (bucket_contains(b, lo))
-                return false;
+                return false; // duplicate
         }
-
-        // Find a bucket with a free lane
-        for (auto &b : buckets) {
-            unsigned cnt = bucket_count(b);
-            if (cnt < lanes_per_bucket) {
-                b = set_count(bucket_set(b, cnt, lo), cnt + 1);
-                return true;
-            }
-        }
-        return false; // full
+        append(p, lo);
+        return true;
     }
 
-    bool erase(uint16_t v) {
+    bool erase(value_type v) {
         assert(v >= 1 && v <= max_value);
-        uint32_t msb = v >> 10;
-        uint16_t lo = v & 0x3FF;
-        auto &buckets = msb ? hi_buckets_ : lo_buckets_;
+        std::size_t p = partition_of(v);
+        value_type lo = stored_of(v);
+        auto &buckets = parts_[p];
 
-        for (auto &b : buckets) {
+        for (std::size_t i = 0; i < buckets_per_partition; ++i) {
+            auto &b = buckets[i];
             int lane = bucket_find(b, lo);
             if (lane >= 0) {
                 unsigned cnt = bucket_count(b);
-                uint16_t last = bucket_get(b, cnt - 1);
+                value_type last = bucket_get(b, cnt - 1);
                 b = bucket_set(b, static_cast<unsigned>(lane), last);
                 b = bucket_set(b, cnt - 1, 0);
                 b = set_count(b, cnt - 1);
+                if (i < cursors_[p])
+                    cursors_[p] = static_cast<cursor_type>(i);
                 return true;
             }
         }
         return false;
     }
 
-    bool contains(uint16_t v) const {
+    bool contains(value_type v) const {
         assert(v >= 1 && v <= max_value);
-        uint32_t msb = v >> 10;
-        uint16_t lo = v & 0x3FF;
-        const auto &buckets = msb ? hi_buckets_ : lo_buckets_;
+        const auto &buckets = parts_[partition_of(v)];
+        return scan_buckets<Layout, buckets_per_partition>(
+                   buckets.data(), stored_of(v)) != buckets_per_partition;
+    }
 
-        for (const auto &b : buckets) {
-            if (bucket_contains(b, lo))
-                return true;
+    // ----- batched lookups -----
+
+    /// Number of needles tested together per pass over the buckets.
+    static constexpr std::size_t batch_width = 4;
+
+    /// out[i] = contains(needles[i]) for i in [0, count).
+    /// Needles in a group may come from different partitions; bucket j of
+    /// each needle's partition is tested in the same step so the loads and
+    /// haszero chains of the group overlap.
+    void contains_many(const value_type *needles, std::size_t count,
+                       bool *out) const {
+        std::size_t i = 0;
+        for (; i + batch_width <= count; i += batch_width) {
+            const uint64_t *parts[batch_width];
+            value_type los[batch_width];
+            uint64_t hits[batch_width] = {};
+            for (std::size_t k = 0; k < batch_width; ++k) {
+                parts[k] = parts_[partition_of(needles[i + k])].data();
+                los[k] = stored_of(needles[i + k]);
+            }
+            for (std::size_t j = 0; j < buckets_per_partition; ++j) {
+                bool all_found = true;
+                for (std::size_t k = 0; k < batch_width; ++k) {
+                    hits[k] |= bucket_match(parts[k][j], los[k]);
+                    all_found &= hits[k] != 0;
+                }
+                if (all_found)
+                    break;
+            }
+            for (std::size_t k = 0; k < batch_width; ++k)
+                out[i + k] = hits[k] != 0;
         }
-        return false;
+        for (; i < count; ++i)
+            out[i] = contains(needles[i]);
+    }
+
+    /// out[i] = slot index of needles[i], or -1 if absent. Slots are
+    /// numbered partition * buckets_per_partition * lanes_per_bucket +
+    /// bucket * lanes_per_bucket + lane; erase may move a value to another
+    /// lane of its bucket, so slots are only stable between updates.
+    void find_many(const value_type *needles, std::size_t count,
+                   int *out) const {
+        std::size_t i = 0;
+        for (; i < count; i += batch_width) {
+            std::size_t group = std::min(batch_width, count - i);
+            std::size_t pidx[batch_width];
+            value_type los[batch_width];
+            int slots[batch_width];
+            for (std::size_t k = 0; k < group; ++k) {
+                pidx[k] = partition_of(needles[i + k]);
+                los[k] = stored_of(needles[i + k]);
+                slots[k] = -1;
+            }
+            for (std::size_t j = 0; j < buckets_per_partition; ++j) {
+                bool all_found = true;
+                for (std::size_t k = 0; k < group; ++k) {
+                    uint64_t hz = bucket_match(parts_[pidx[k]][j], los[k]);
+                    if (slots[k] < 0 && hz != 0)
+                        slots[k] = static_cast<int>(
+                            (pidx[k] * buckets_per_partition + j) *
+                                lanes_per_bucket +
+                            __builtin_ctzll(hz) / lane_bits);
+                    all_found &= slots[k] >= 0;
+                }
+                if (all_found)
+                    break;
+            }
+            for (std::size_t k = 0; k < group; ++k)
+                out[i + k] = slots[k];
+        }
+    }
+
+    // ----- set algebra -----
+    // Partition by partition, each bucket of one set is matched against
+    // every bucket of the same partition of the other: the occupied lanes
+    // of the other bucket are rotated through every lane position and
+    // compared with an exact zero test, so no lane is extracted for the
+    // match. Results are built by appending the kept values.
+
+    /// Same layout, any capacity.
+    template <std::size_t C2>
+    using Like = BasicBucketedSet<ValueBits, PartitionBits, C2, LanesPerBucket>;
+
+    /// Number of values in both this set and o.
+    template <std::size_t C2>
+    std::size_t intersection_size(const Like<C2> &o) const {
+        std::size_t n = 0;
+        match_buckets(o, [&](std::size_t, uint64_t, uint64_t m) {
+            n += static_cast<std::size_t>(__builtin_popcountll(m));
+            return true;
+        });
+        return n;
+    }
+
+    /// True if every value of this set is in o.
+    template <std::size_t C2> bool is_subset_of(const Like<C2> &o) const {
+        return match_buckets(o, [](std::size_t, uint64_t b, uint64_t m) {
+            return m == Layout::occupied_high(b);
+        });
+    }
+
+    /// Values in both this set and o.
+    template <std::size_t C2>
+    BasicBucketedSet intersect(const Like<C2> &o) const {
+        BasicBucketedSet r;
+        match_buckets(o, [&](std::size_t p, uint64_t b, uint64_t m) {
+            r.append_lanes(p, b, m);
+            return true;
+        });
+        return r;
+    }
+
+    /// Values in this set but not in o.
+    template <std::size_t C2>
+    BasicBucketedSet difference(const Like<C2> &o) const {
+        BasicBucketedSet r;
+        match_buckets(o, [&](std::size_t p, uint64_t b, uint64_t m) {
+            r.append_lanes(p, b, Layout::occupied_high(b) & ~m);
+            return true;
+        });
+        return r;
+    }
+
+    /// Values in either set. The result has room for every bucket of both
+    /// operands: this set's buckets are copied, then o's values that are
+    /// not in this set are appended.
+    template <std::size_t C2>
+    Like<(buckets_per_partition + Like<C2>::buckets_per_partition) *
+         lanes_per_bucket>
+    unite(const Like<C2> &o) const {
+        Like<(buckets_per_partition + Like<C2>::buckets_per_partition) *
+             lanes_per_bucket>
+            r;
+        for (std::size_t p = 0; p < partitions; ++p) {
+            for (std::size_t i = 0; i < buckets_per_partition; ++i)
+                r.parts_[p][i] = parts_[p][i];
+            r.cursors_[p] = cursors_[p];
+        }
+        o.match_buckets(*this, [&](std::size_t p, uint64_t b, uint64_t m) {
+            r.append_lanes(p, b, Layout::occupied_high(b) & ~m);
+            return true;
+        });
+        return r;
+    }
+
+    // ----- iteration -----
+    // Partition by partition, bucket by bucket, lanes [0, count) of each
+    // bucket; the occupied lanes come from the count field as guard-bit
+    // masks and are walked with a ctz loop. Each value is the stored low
+    // bits with the partition index put back on top. Order is storage
+    // order and is unspecified across insert/erase.
+
+    /// Call f(v) for every stored value.
+    template <class F> void for_each(F f) const {
+        for (std::size_t p = 0; p < partitions; ++p) {
+            uint64_t top = uint64_t(p) << stored_bits;
+            std::size_t n = used_buckets(p);
+            for (std::size_t i = 0; i < n; ++i) {
+                uint64_t b = parts_[p][i];
+                for (uint64_t m = Layout::occupied_high(b); m != 0;
+                     m &= m - 1)
+                    f(static_cast<value_type>(top | lane_at(b, m)));
+            }
+        }
+    }
+
+    /// Forward iterator over the stored values. Dereferences to the value
+    /// itself (there is no stored object to refer to). Invalidated by any
+    /// insert or erase.
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename BasicBucketedSet::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = value_type;
+
+        const_iterator() noexcept = default;
+
+        value_type operator*() const noexcept {
+            return static_cast<value_type>(
+                (uint64_t(p_) << stored_bits) |
+                lane_at(set_->parts_[p_][i_], lanes_));
+        }
+
+        const_iterator &operator++() noexcept {
+            lanes_ &= lanes_ - 1;
+            if (lanes_ == 0)
+                seek(p_, i_ + 1);
+            return *this;
+        }
+        const_iterator operator++(int) noexcept {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator &a,
+                               const const_iterator &b) noexcept {
+            return a.p_ == b.p_ && a.i_ == b.i_ && a.lanes_ == b.lanes_;
+        }
+        friend bool operator!=(const const_iterator &a,
+                               const const_iterator &b) noexcept {
+            return !(a == b);
+        }
+
+      private:
+        friend class BasicBucketedSet;
+
+        const_iterator(const BasicBucketedSet *set, std::size_t p) noexcept
+            : set_(set) {
+            seek(p, 0);
+        }
+
+        /// Move to the first occupied lane at or after bucket i of
+        /// partition p.
+        void seek(std::size_t p, std::size_t i) noexcept {
+            for (; p < partitions; ++p, i = 0) {
+                for (; i < buckets_per_partition; ++i) {
+                    lanes_ = Layout::occupied_high(set_->parts_[p][i]);
+                    if (lanes_ != 0) {
+                        p_ = p;
+                        i_ = i;
+                        return;
+                    }
+                }
+            }
+            p_ = partitions;
+            i_ = 0;
+        }
+
+        const BasicBucketedSet *set_ = nullptr;
+        std::size_t p_ = partitions;
+        std::size_t i_ = 0;
+        uint64_t lanes_ = 0; // occupied lanes of bucket i_ not yet visited
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept {
+        return const_iterator(this, partitions);
     }
 
     static constexpr std::size_t size() noexcept { return capacity; }
 
   private:
-    // 11-bit lane constants for 3-lane SWAR in uint64_t
-    static constexpr unsigned lane_bits = 11;
-    static constexpr uint64_t lane_mask = 0x3FFu; // 10 data bits per lane
-    static constexpr unsigned count_shift = 33;
-
-    // haszero constants: broadcast_one has a 1 at the LSB of each 11-bit lane
-    static constexpr uint64_t broadcast_one =
-        (1ULL) | (1ULL << 11) | (1ULL << 22);
-    // high_bits has the guard bit (MSB) of each 11-bit lane set
-    static constexpr uint64_t high_bits =
-        (1ULL << 10) | (1ULL << 21) | (1ULL << 32);
-    // Mask for all 3 lanes' data+guard bits (33 bits)
-    static constexpr uint64_t all_lanes = (1ULL << 33) - 1;
-
-    // Count-based validity masks: after haszero, result bits appear at
-    // guard-bit positions (10, 21, 32). Mask by count to ignore empty lanes.
-    static constexpr uint64_t count_masks[4] = {
-        0,
-        (1ULL << 10),
-        (1ULL << 10) | (1ULL << 21),
-        (1ULL << 10) | (1ULL << 21) | (1ULL << 32),
-    };
+    template <unsigned, unsigned, std::size_t, unsigned>
+    friend class BasicBucketedSet;
 
-    /// SWAR haszero contains: XOR with broadcast, detect zero lanes.
-    static constexpr bool bucket_contains(uint64_t b, uint16_t lo) {
-        uint64_t data = b & all_lanes;
-        uint64_t bcast = static_cast<uint64_t>(lo) * broadcast_one;
-        uint64_t xored = data ^ bcast;
-        uint64_t hz = (xored - broadcast_one) & ~xored & high_bits;
-        return (hz & count_masks[b >> count_shift]) != 0;
+    // Lane and count-field constants shared with the scan kernels
+    // (word_scan.hpp).
+    using Layout = BucketLayout<lane_bits, lanes_per_bucket>;
+    static constexpr uint64_t lane_mask = (uint64_t(1) << stored_bits) - 1;
+    static constexpr unsigned count_shift = Layout::count_shift;
+    static constexpr uint64_t count_mask = Layout::count_mask;
+
+    static constexpr std::size_t partition_of(value_type v) {
+        return static_cast<std::size_t>(v >> stored_bits);
+    }
+
+    static constexpr value_type stored_of(value_type v) {
+        return static_cast<value_type>(v & lane_mask);
+    }
+
+    /// SWAR haszero match: XOR with broadcast, detect zero lanes, and keep
+    /// only occupied lanes. Result bits sit at the guard-bit positions.
+    static constexpr uint64_t bucket_match(uint64_t b, value_type lo) {
+        return Layout::match(b, lo);
+    }
+
+    /// SWAR haszero contains.
+    static constexpr bool bucket_contains(uint64_t b, value_type lo) {
+        return bucket_match(b, lo) != 0;
     }
 
     /// SWAR find: returns lane index of match, or -1.
-    static constexpr int bucket_find(uint64_t b, uint16_t lo) {
-        uint64_t data = b & all_lanes;
-        uint64_t bcast = static_cast<uint64_t>(lo) * broadcast_one;
-        uint64_t xored = data ^ bcast;
-        uint64_t hz = (xored - broadcast_one) & ~xored & high_bits;
-        hz &= count_masks[b >> count_shift];
+    static constexpr int bucket_find(uint64_t b, value_type lo) {
+        uint64_t hz = bucket_match(b, lo);
         if (hz == 0) return -1;
         return static_cast<int>(__builtin_ctzll(hz) / lane_bits);
     }
@@ -144,23 +412,143 @@ class BucketedSet {
     }
 
     static constexpr uint64_t set_count(uint64_t b, unsigned cnt) {
-        return (b & ~(3ULL << count_shift))
+        return (b & ~count_mask)
              | (static_cast<uint64_t>(cnt) << count_shift);
     }
 
-    static constexpr uint16_t bucket_get(uint64_t b, unsigned lane) {
-        return static_cast<uint16_t>((b >> (lane * lane_bits)) & lane_mask);
+    static constexpr value_type bucket_get(uint64_t b, unsigned lane) {
+        return static_cast<value_type>((b >> (lane * lane_bits)) & lane_mask);
+    }
+
+    /// Stored bits of the lane of b whose guard is the lowest set bit of m.
+    static constexpr uint64_t lane_at(uint64_t b, uint64_t m) noexcept {
+        unsigned shift =
+            static_cast<unsigned>(__builtin_ctzll(m)) - stored_bits;
+        return (b >> shift) & lane_mask;
     }
 
     static constexpr uint64_t bucket_set(uint64_t b, unsigned lane,
-                                         uint16_t val10) {
+                                         value_type lo) {
         unsigned shift = lane * lane_bits;
         uint64_t mask = lane_mask << shift;
-        return (b & ~mask) | (static_cast<uint64_t>(val10) << shift);
+        return (b & ~mask) | (static_cast<uint64_t>(lo) << shift);
+    }
+
+    /// Store lo in the cursor bucket of partition p, which must not be full
+    /// and must not already hold lo. Moves the cursor forward, to the next
+    /// non-full bucket, when this fills its bucket.
+    void append(std::size_t p, value_type lo) {
+        auto &buckets = parts_[p];
+        auto &cursor = cursors_[p];
+        auto &b = buckets[cursor];
+        unsigned cnt = bucket_count(b);
+        b = set_count(bucket_set(b, cnt, lo), cnt + 1);
+        if (cnt + 1 == lanes_per_bucket) {
+            std::size_t next = cursor + std::size_t(1);
+            while (next < buckets_per_partition &&
+                   bucket_count(buckets[next]) == lanes_per_bucket)
+                ++next;
+            cursor = static_cast<cursor_type>(next);
+        }
     }
 
-    std::array<uint64_t, buckets_per_half> lo_buckets_;
-    std::array<uint64_t, buckets_per_half> hi_buckets_;
+    /// Append the lanes of bucket b flagged (at guard positions) in keep.
+    void append_lanes(std::size_t p, uint64_t b, uint64_t keep) {
+        for (; keep != 0; keep &= keep - 1) {
+            unsigned lane =
+                static_cast<unsigned>(__builtin_ctzll(keep)) / lane_bits;
+            append(p, bucket_get(b, lane));
+        }
+    }
+
+    /// One past the last non-empty bucket of partition p. Partitions are
+    /// sized for Capacity values, so most of a partition is usually empty.
+    std::size_t used_buckets(std::size_t p) const noexcept {
+        std::size_t n = buckets_per_partition;
+        while (n > 0 && bucket_count(parts_[p][n - 1]) == 0)
+            --n;
+        return n;
+    }
+
+    /// Call f(p, b, m) for each non-empty bucket b of partition p, where m
+    /// flags the lanes of b whose value is in o. Stops, returning false,
+    /// as soon as f returns false.
+    template <class Other, class F>
+    bool match_buckets(const Other &o, F f) const {
+        for (std::size_t p = 0; p < partitions; ++p) {
+            std::size_t n = used_buckets(p), end = o.used_buckets(p);
+            for (std::size_t i = 0; i < n; ++i) {
+                uint64_t b = parts_[p][i];
+                if (bucket_count(b) != 0 &&
+                    !f(p, b, o.member_lanes(p, end, b)))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /// Guard bits of the occupied lanes of bucket b (of a set with this
+    /// layout) whose value is stored in buckets [0, end) of partition p.
+    uint64_t member_lanes(std::size_t p, std::size_t end, uint64_t b) const {
+        uint64_t want = Layout::occupied_high(b);
+        uint64_t x = b & Layout::all_lanes;
+        uint64_t m = 0;
+        for (std::size_t i = 0; i < end; ++i) {
+            uint64_t o = parts_[p][i];
+            uint64_t ov = o & Layout::all_lanes;
+            uint64_t occ = Layout::occupied_high(o);
+            for (unsigned r = 0; r < lanes_per_bucket; ++r) {
+                uint64_t d = x ^ rotate_lanes(ov, r);
+                // Exact zero test: the guard survives the subtraction
+                // unless the lane is zero.
+                uint64_t eq = ~((d | Layout::high_bits) -
+                                Layout::broadcast_one) &
+                              Layout::high_bits;
+                m |= eq & rotate_lanes(occ, r);
+            }
+            m &= want;
+            if (m == want)
+                break;
+        }
+        return m;
+    }
+
+    /// Rotate the lanes of x (count field cleared) down by r lanes.
+    static constexpr uint64_t rotate_lanes(uint64_t x, unsigned r) {
+        if (r == 0)
+            return x;
+        return ((x >> (r * lane_bits)) |
+                (x << ((lanes_per_bucket - r) * lane_bits))) &
+               Layout::all_lanes;
+    }
+
+    // Smallest type that can index one past the last bucket of a partition.
+    using cursor_type = std::conditional_t<
+        (buckets_per_partition < 0xFF), uint8_t,
+        std::conditional_t<(buckets_per_partition < 0xFFFF), uint16_t,
+                           std::size_t>>;
+
+    std::array<std::array<uint64_t, buckets_per_partition>, partitions> parts_;
+    /// Per partition: first bucket with a free lane, or
+    /// buckets_per_partition if the partition is full. Buckets before it
+    /// are full.
+    std::array<cursor_type, partitions> cursors_;
 };
 
+/// A fixed-capacity set of 11-bit integers: BasicBucketedSet with a
+/// single MSB partition bit and 3 lanes per bucket.
+///
+/// Bucket layout (uint64_t):
+///   [...unused...][count:2][G2][val2:10][G1][val1:10][G0][val0:10]
+///      63..35       34:33   32  31..22   21  20..11   10   9..0
+///
+/// Guard bits (G0=bit10, G1=bit21, G2=bit32) enable the haszero SWAR trick
+/// for parallel 3-lane matching in a single operation.
+///
+/// Values are split by MSB (bit 10): partition 0 stores values [1,1023],
+/// partition 1 stores values [1024,2047]. The lower 10 bits are stored
+/// in the lane data bits; guard bits are always 0 for valid data.
+template <std::size_t Capacity>
+using BucketedSet = BasicBucketedSet<11, 1, Capacity, 3>;
+
 } // namespace swar
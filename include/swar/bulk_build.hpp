@@ -0,0 +1,237 @@
+#pragma once
+
+#include "dispatch.hpp"
+#include "packed_set_arena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace swar {
+
+/// One input record for bulk_build: value belongs to the set of entity.
+struct EntityValue {
+    uint32_t entity;
+    uint32_t value;
+};
+
+/// What bulk_build stored.
+struct BulkBuildStats {
+    /// Values actually added to their entity's set; repeats of a value
+    /// already in the set are not counted.
+    std::size_t inserted = 0;
+    /// Pairs (including repeats) whose entity's set was full: a value
+    /// that never fit is counted again each time it reappears, as a
+    /// failed arena.insert would be.
+    std::size_t dropped = 0;
+};
+
+namespace detail {
+
+/// Run f(t) for t in [0, threads) on `threads` threads (the caller's
+/// included) and wait for all of them.
+template <class F> void run_workers(unsigned threads, F f) {
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(f, t);
+    f(0u);
+    for (auto &th : pool)
+        th.join();
+}
+
+/// A worker's remaining task indices [begin, end), packed in one atomic
+/// word: the owner takes from the front, thieves from the back, each with
+/// one CAS. begin only grows and end only shrinks, so there is no ABA.
+struct alignas(CacheLineAllocator<char>::alignment) TaskRange {
+    std::atomic<uint64_t> range{0};
+
+    static constexpr uint64_t pack(uint32_t begin, uint32_t end) noexcept {
+        return (uint64_t(begin) << 32) | end;
+    }
+
+    /// Next task from the front, or false if none are left.
+    bool take_front(uint32_t &task) noexcept {
+        uint64_t r = range.load();
+        for (;;) {
+            uint32_t b = static_cast<uint32_t>(r >> 32);
+            uint32_t e = static_cast<uint32_t>(r);
+            if (b >= e)
+                return false;
+            if (range.compare_exchange_weak(r, pack(b + 1, e))) {
+                task = b;
+                return true;
+            }
+        }
+    }
+
+    /// Last task, taken by another worker, or false if none are left.
+    bool steal_back(uint32_t &task) noexcept {
+        uint64_t r = range.load();
+        for (;;) {
+            uint32_t b = static_cast<uint32_t>(r >> 32);
+            uint32_t e = static_cast<uint32_t>(r);
+            if (b >= e)
+                return false;
+            if (range.compare_exchange_weak(r, pack(b, e - 1))) {
+                task = e - 1;
+                return true;
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+/// Minimum tasks per worker bulk_build cuts the entity range into; more
+/// tasks balance skewed entities better, at some per-task overhead.
+inline constexpr std::size_t bulk_build_tasks_per_thread = 8;
+
+/// Largest arena span of one bulk_build task, so the sets a task writes
+/// stay cache resident while its pairs land on them in random order.
+inline constexpr std::size_t bulk_build_task_bytes = std::size_t(256) << 10;
+
+/// Build one set per entity from a flat stream of (entity, value) pairs
+/// into arena, which is resized to hold `entities` sets: set h holds
+/// entity h's distinct values. Entities with no pairs get an empty set.
+/// Entities must be < `entities` and values in [1, max_safe_value]. The
+/// result, lane for lane, is that of calling arena.insert(entity, value)
+/// on each pair in stream order; values that find their set full are
+/// counted as dropped. threads = 0 uses hardware_concurrency().
+///
+/// The entity range is cut into contiguous tasks of a power-of-two
+/// number of entities (routing is a shift), at most bulk_build_task_bytes
+/// of arena each. Three parallel passes then replace the random-access
+/// insert loop:
+///   1. each worker counts its slice of the input per task;
+///   2. after a serial prefix sum over those counts, each worker
+///      scatters its slice into a buffer grouped by task, keeping stream
+///      order within a task;
+///   3. workers run tasks from their own run of task indices, stealing
+///      from the back of other workers' runs once theirs is empty. A
+///      task clears its sets and inserts its pairs straight into the
+///      arena words: the SWAR scan dedups, and every access stays within
+///      the task's cache-sized span.
+/// Tasks own disjoint entity ranges, so no set is written by two
+/// workers and no lock is taken.
+template <unsigned N, std::size_t Capacity, bool AlignStride>
+BulkBuildStats bulk_build(PackedSetArena<N, Capacity, AlignStride> &arena,
+                          const EntityValue *pairs, std::size_t n,
+                          std::size_t entities, unsigned threads = 0) {
+    using Arena = PackedSetArena<N, Capacity, AlignStride>;
+    using Word = typename Arena::Word;
+    constexpr std::size_t words = Arena::words_per_set;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    arena.resize(entities);
+    if (entities == 0)
+        return {};
+
+    const std::size_t min_tasks =
+        std::size_t(threads) * bulk_build_tasks_per_thread;
+    unsigned task_shift = 0;
+    while ((std::size_t(2) << task_shift) * Arena::bytes_per_set() <=
+               bulk_build_task_bytes &&
+           (entities >> (task_shift + 1)) >= min_tasks)
+        ++task_shift;
+    const std::size_t per_task = std::size_t(1) << task_shift;
+    const std::size_t tasks = (entities + per_task - 1) / per_task;
+    auto task_of = [task_shift](uint32_t e) {
+        return std::size_t(e) >> task_shift;
+    };
+    auto slice_begin = [&](unsigned t) { return t * n / threads; };
+
+    // Pass 1: per-worker, per-task counts.
+    std::vector<std::size_t> counts(std::size_t(threads) * tasks);
+    detail::run_workers(threads, [&](unsigned t) {
+        std::size_t *c = counts.data() + std::size_t(t) * tasks;
+        for (std::size_t i = slice_begin(t); i < slice_begin(t + 1); ++i) {
+            assert(pairs[i].entity < entities);
+            ++c[task_of(pairs[i].entity)];
+        }
+    });
+
+    // Offsets: task k's pairs start at task_begin[k]; within it, worker
+    // t's after those of workers [0, t).
+    std::vector<std::size_t> task_begin(tasks + 1);
+    std::size_t pos = 0;
+    for (std::size_t k = 0; k < tasks; ++k) {
+        task_begin[k] = pos;
+        for (unsigned t = 0; t < threads; ++t) {
+            std::size_t &c = counts[std::size_t(t) * tasks + k];
+            std::size_t here = c;
+            c = pos;
+            pos += here;
+        }
+    }
+    task_begin[tasks] = pos;
+
+    // Pass 2: scatter by task.
+    std::unique_ptr<EntityValue[]> grouped(new EntityValue[n]);
+    detail::run_workers(threads, [&](unsigned t) {
+        std::size_t *next = counts.data() + std::size_t(t) * tasks;
+        for (std::size_t i = slice_begin(t); i < slice_begin(t + 1); ++i)
+            grouped[next[task_of(pairs[i].entity)]++] = pairs[i];
+    });
+
+    // Pass 3: build the sets, with work stealing.
+    std::unique_ptr<detail::TaskRange[]> ranges(
+        new detail::TaskRange[threads]);
+    for (unsigned t = 0; t < threads; ++t)
+        ranges[t].range.store(detail::TaskRange::pack(
+            static_cast<uint32_t>(t * tasks / threads),
+            static_cast<uint32_t>((t + 1) * tasks / threads)));
+    std::vector<BulkBuildStats> stats(threads);
+
+    detail::run_workers(threads, [&](unsigned t) {
+        BulkBuildStats st;
+
+        auto run_task = [&](std::size_t k) {
+            const std::size_t first = k * per_task;
+            const std::size_t last = std::min(entities, first + per_task);
+            for (std::size_t e = first; e < last; ++e)
+                arena.clear(static_cast<typename Arena::handle>(e));
+
+            for (std::size_t i = task_begin[k]; i < task_begin[k + 1]; ++i) {
+                const EntityValue p = grouped[i];
+                assert(p.value >= 1 && p.value <= Word::max_safe_value);
+                Word *w = arena.set_words(p.entity);
+                if (scan_words<N, words>(w, p.value) != words)
+                    continue; // duplicate
+                bool placed = false;
+                for (std::size_t wi = 0; wi < words && !placed; ++wi) {
+                    int lane = w[wi].find_zero();
+                    if (lane >= 0) {
+                        w[wi] = w[wi].set(static_cast<unsigned>(lane), p.value);
+                        placed = true;
+                    }
+                }
+                ++(placed ? st.inserted : st.dropped);
+            }
+        };
+
+        uint32_t k;
+        while (ranges[t].take_front(k))
+            run_task(k);
+        for (unsigned d = 1; d < threads; ++d) {
+            auto &victim = ranges[(t + d) % threads];
+            while (victim.steal_back(k))
+                run_task(k);
+        }
+        stats[t] = st;
+    });
+
+    BulkBuildStats total;
+    for (const auto &s : stats) {
+        total.inserted += s.inserted;
+        total.dropped += s.dropped;
+    }
+    return total;
+}
+
+} // namespace swar
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "bucketed_set.hpp"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+namespace swar {
+
+/// A BasicBucketedSet that many threads can read and update at once.
+///
+/// The bucket layout is unchanged: lanes [0, count) hold values and the
+/// count field sits above the lanes in the same uint64_t. Each bucket is
+/// a std::atomic<uint64_t>, so one CAS moves a lane and the count
+/// together. Operations are non-blocking except for concurrent inserts
+/// of the same value, which wait on each other (see below):
+///   - contains is wait-free: one load and haszero match per bucket of
+///     the value's partition.
+///   - erase is one CAS per attempt: the last lane moves into the hole,
+///     the old last lane is cleared and count drops by one, as in
+///     BasicBucketedSet::erase.
+///   - insert appends to the first non-full bucket with one CAS
+///     (lane[count] = lo, count + 1); inserts racing for the same bucket
+///     see the CAS fail and retry on the reloaded bucket.
+///
+/// Two inserts of v landing in different buckets of its partition would
+/// store it twice, so an insert first appends lo with the lane guard set
+/// (pending, invisible to contains and erase), rescans the partition and
+/// only then clears the guard, as ConcurrentPackedSet does per slot. The
+/// append CAS refuses a bucket that already holds lo in either state, so
+/// a bucket holds at most one copy, and a pending copy is identified by
+/// (bucket, lo) even when erase moves it to another lane. Of two pending
+/// copies the one in the lower bucket wins: the higher inserter withdraws
+/// its own claim, the lower one waits for it to go. Only the claiming
+/// thread ever changes a pending lane, so a preempted inserter stalls
+/// every other insert of its value and insert is not lock-free.
+///
+/// There is no insert cursor: an insert walks the partition's buckets
+/// from the first, which the duplicate check has to do anyway.
+template <unsigned ValueBits, unsigned PartitionBits, std::size_t Capacity,
+          unsigned LanesPerBucket =
+              max_bucket_lanes(ValueBits - PartitionBits + 1)>
+class BasicConcurrentBucketedSet {
+    using Base =
+        BasicBucketedSet<ValueBits, PartitionBits, Capacity, LanesPerBucket>;
+
+  public:
+    using value_type = typename Base::value_type;
+
+    static constexpr unsigned value_bits = Base::value_bits;
+    static constexpr value_type max_value = Base::max_value;
+    static constexpr unsigned partition_bits = Base::partition_bits;
+    static constexpr std::size_t partitions = Base::partitions;
+    static constexpr unsigned stored_bits = Base::stored_bits;
+    static constexpr unsigned lane_bits = Base::lane_bits;
+    static constexpr unsigned lanes_per_bucket = Base::lanes_per_bucket;
+    static constexpr std::size_t buckets_per_partition =
+        Base::buckets_per_partition;
+    static constexpr std::size_t capacity = Capacity;
+
+    BasicConcurrentBucketedSet() noexcept {
+        for (auto &buckets : parts_)
+            for (auto &b : buckets)
+                b.store(0, std::memory_order_relaxed);
+    }
+
+    BasicConcurrentBucketedSet(const BasicConcurrentBucketedSet &) = delete;
+    BasicConcurrentBucketedSet &
+    operator=(const BasicConcurrentBucketedSet &) = delete;
+
+    /// Insert v. Returns true if this call added it, false if v was
+    /// already present (or became present concurrently) or its partition
+    /// is full.
+    bool insert(value_type v) {
+        assert(v >= 1 && v <= max_value);
+        auto &buckets = parts_[partition_of(v)];
+        const uint64_t lo = stored_of(v);
+        const uint64_t pending = lo | pending_bit;
+        for (;;) {
+            Claim c = claim(buckets, lo, pending);
+            if (c.state == Claim::present)
+                return false;
+            if (c.state == Claim::busy) {
+                // An insert of v in flight must finish before this one
+                // can decide whether v is present.
+                std::this_thread::yield();
+                continue;
+            }
+            if (c.bucket == buckets_per_partition)
+                return false; // full
+
+            switch (settle(buckets, lo, pending, c.bucket)) {
+            case Outcome::lost:
+                return false;
+            case Outcome::retry:
+                continue;
+            case Outcome::won:
+                break;
+            }
+            commit(buckets[c.bucket], pending);
+            return true;
+        }
+    }
+
+    /// Remove v. Returns true if this call removed it.
+    bool erase(value_type v) {
+        assert(v >= 1 && v <= max_value);
+        auto &buckets = parts_[partition_of(v)];
+        const uint64_t lo = stored_of(v);
+        for (auto &a : buckets) {
+            uint64_t b = a.load();
+            for (;;) {
+                uint64_t m = Layout::match(b, lo);
+                if (m == 0)
+                    break;
+                if (a.compare_exchange_weak(b, remove_lane(b, m)))
+                    return true;
+                // b reloaded: lanes may have moved or v been erased.
+            }
+        }
+        return false;
+    }
+
+    /// True if v is committed. Wait-free.
+    bool contains(value_type v) const {
+        assert(v >= 1 && v <= max_value);
+        const uint64_t lo = stored_of(v);
+        for (const auto &a : parts_[partition_of(v)]) {
+            if (Layout::match(a.load(), lo) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    /// Snapshot of bucket i of partition p (for inspection /
+    /// benchmarking). Pending lanes have their guard bit set.
+    uint64_t load_bucket(std::size_t p, std::size_t i) const noexcept {
+        assert(p < partitions && i < buckets_per_partition);
+        return parts_[p][i].load();
+    }
+
+    static constexpr std::size_t size() noexcept { return capacity; }
+
+  private:
+    using Layout = BucketLayout<lane_bits, lanes_per_bucket>;
+    using Buckets =
+        std::array<std::atomic<uint64_t>, buckets_per_partition>;
+
+    static constexpr uint64_t lane_mask = (uint64_t(1) << stored_bits) - 1;
+    static constexpr uint64_t full_lane = (uint64_t(1) << lane_bits) - 1;
+    static constexpr uint64_t pending_bit = uint64_t(1) << stored_bits;
+    static constexpr uint64_t count_one = uint64_t(1) << Layout::count_shift;
+
+    struct Claim {
+        enum State { claimed, present, busy } state;
+        std::size_t bucket;
+    };
+
+    enum class Outcome { won, lost, retry };
+
+    static constexpr std::size_t partition_of(value_type v) {
+        return static_cast<std::size_t>(v >> stored_bits);
+    }
+
+    static constexpr uint64_t stored_of(value_type v) {
+        return v & lane_mask;
+    }
+
+    static constexpr unsigned bucket_count(uint64_t b) {
+        return static_cast<unsigned>(b >> Layout::count_shift);
+    }
+
+    /// b with x appended as lane count and count raised by one.
+    static constexpr uint64_t append_lane(uint64_t b, uint64_t x) {
+        return (b | (x << (bucket_count(b) * lane_bits))) + count_one;
+    }
+
+    /// b with the lane whose guard is the lowest set bit of m removed:
+    /// the last lane (guard included) moves into it and count drops.
+    static constexpr uint64_t remove_lane(uint64_t b, uint64_t m) {
+        unsigned lane =
+            static_cast<unsigned>(__builtin_ctzll(m)) / lane_bits;
+        unsigned last = bucket_count(b) - 1;
+        uint64_t moved = (b >> (last * lane_bits)) & full_lane;
+        b &= ~(full_lane << (last * lane_bits));
+        if (lane != last) {
+            b &= ~(full_lane << (lane * lane_bits));
+            b |= moved << (lane * lane_bits);
+        }
+        return b - count_one;
+    }
+
+    /// Append pending to the first non-full bucket. Stops early if a
+    /// bucket on the way holds lo committed (present) or pending (busy);
+    /// the CAS re-checks the bucket it lands in. {claimed,
+    /// buckets_per_partition} if every bucket is full.
+    static Claim claim(Buckets &buckets, uint64_t lo, uint64_t pending) {
+        for (std::size_t i = 0; i < buckets_per_partition; ++i) {
+            uint64_t b = buckets[i].load();
+            for (;;) {
+                if (Layout::match(b, lo) != 0)
+                    return {Claim::present, i};
+                if (Layout::match(b, pending) != 0)
+                    return {Claim::busy, i};
+                if (bucket_count(b) == lanes_per_bucket)
+                    break;
+                if (buckets[i].compare_exchange_weak(b,
+                                                     append_lane(b, pending)))
+                    return {Claim::claimed, i};
+            }
+        }
+        return {Claim::claimed, buckets_per_partition};
+    }
+
+    /// Resolve other copies of lo against our pending copy in bucket
+    /// mine. Waits out pending copies in higher buckets; withdraws ours
+    /// if lo is committed elsewhere (lost) or pending in a lower bucket
+    /// (retry).
+    static Outcome settle(Buckets &buckets, uint64_t lo, uint64_t pending,
+                          std::size_t mine) {
+        for (std::size_t i = 0; i < buckets_per_partition; ++i) {
+            if (i == mine)
+                continue; // the claim CAS kept lo out of it
+            uint64_t b = buckets[i].load();
+            for (;;) {
+                if (Layout::match(b, lo) != 0) {
+                    withdraw(buckets[mine], pending);
+                    return Outcome::lost;
+                }
+                if (Layout::match(b, pending) == 0)
+                    break;
+                if (i < mine) {
+                    withdraw(buckets[mine], pending);
+                    return Outcome::retry;
+                }
+                // A higher pending copy: its owner will see ours and
+                // withdraw, or has already passed us and will commit.
+                std::this_thread::yield();
+                b = buckets[i].load();
+            }
+        }
+        return Outcome::won;
+    }
+
+    /// Clear the guard of our pending lane, wherever erase has moved it.
+    static void commit(std::atomic<uint64_t> &a, uint64_t pending) {
+        uint64_t b = a.load();
+        for (;;) {
+            uint64_t m = Layout::match(b, pending);
+            assert(m != 0);
+            if (a.compare_exchange_weak(b, b & ~(m & (0 - m))))
+                return;
+        }
+    }
+
+    /// Remove our pending lane.
+    static void withdraw(std::atomic<uint64_t> &a, uint64_t pending) {
+        uint64_t b = a.load();
+        for (;;) {
+            uint64_t m = Layout::match(b, pending);
+            assert(m != 0);
+            if (a.compare_exchange_weak(b, remove_lane(b, m)))
+                return;
+        }
+    }
+
+    std::array<Buckets, partitions> parts_;
+};
+
+/// ConcurrentBucketedSet: the BucketedSet layout (11-bit values, two
+/// partitions, three 11-bit lanes and a 2-bit count at bits 34:33 per
+/// bucket) with CAS updates that only block on a concurrent insert of
+/// the same value.
+template <std::size_t Capacity>
+using ConcurrentBucketedSet = BasicConcurrentBucketedSet<11, 1, Capacity, 3>;
+
+} // namespace swar
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "packed_word.hpp"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace swar {
+
+/// A fixed-capacity PackedSet that many threads can read and update at
+/// once. Each word is a std::atomic<uint64_t> and every update is one CAS
+/// on the word holding the lane. Operations are non-blocking except for
+/// concurrent inserts of the same value, which wait on each other (see
+/// below), so insert is not lock-free.
+///
+/// Stored values must be in [1, max_safe_value] (2^(N-1) - 1), as for
+/// PackedSet<N>: the lane MSB is used to mark an insert in progress.
+/// Lanes are in one of three states:
+///   0          empty
+///   v | guard  pending: claimed by an insert of v, not yet visible
+///   v          committed: v is in the set
+/// Lanes are compared with the exact (ExactZero) test, so a pending lane
+/// never matches a committed value.
+///
+///   - contains is wait-free: one atomic load and zero test per word.
+///   - erase scans for committed v and CASes its lane to 0, rescanning if
+///     the word changed underneath.
+///   - insert claims a zero lane (find_zero) with a pending CAS, rescans
+///     every other lane, then commits with a second CAS that clears the
+///     guard. Two concurrent inserts of v could both land, so the rescan
+///     settles duplicates: a committed copy elsewhere wins (withdraw and
+///     return false); of two pending copies, the one in the lower slot
+///     wins. The higher inserter withdraws its own claim when it sees the
+///     lower one; the lower waits for the higher copy to go (withdrawn or
+///     committed) rather than clearing it, so a pending lane is only ever
+///     changed by the thread that claimed it. All operations are seq_cst,
+///     so of two racing inserts at least one sees the other's claim.
+///
+/// An insert that finds a pending copy of its own value waits for that
+/// insert to commit or withdraw, so only inserts of the same value can
+/// delay each other; inserts and erases of distinct values never do. A
+/// preempted inserter stalls every other insert of its value until it
+/// runs again.
+template <unsigned N, std::size_t Capacity> class ConcurrentPackedSet {
+    static_assert(Capacity > 0, "Capacity must be > 0");
+
+  public:
+    /// Lane arithmetic: exact zero test over all N bits, so the guard
+    /// (pending) bit takes part in every comparison.
+    using Word = PackedWord<N, ExactZero>;
+    static constexpr unsigned lanes_per_word = Word::lanes;
+    static constexpr std::size_t num_words =
+        (Capacity + lanes_per_word - 1) / lanes_per_word;
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr uint64_t max_safe_value = PackedWord<N>::max_safe_value;
+
+    ConcurrentPackedSet() noexcept {
+        for (auto &w : words_)
+            w.store(0, std::memory_order_relaxed);
+    }
+
+    ConcurrentPackedSet(const ConcurrentPackedSet &) = delete;
+    ConcurrentPackedSet &operator=(const ConcurrentPackedSet &) = delete;
+
+    /// Insert v. Returns true if this call added it, false if v was
+    /// already present (or became present concurrently) or the set is
+    /// full.
+    bool insert(uint64_t v) {
+        assert(v >= 1 && v <= max_safe_value);
+        const uint64_t pending = v | pending_bit;
+        for (;;) {
+            // An insert of v in flight must finish before this one can
+            // decide whether v is present.
+            Slot found = find(v, pending);
+            if (found.committed)
+                return false;
+            if (found.word != num_words) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            Slot mine = claim(pending);
+            if (mine.word == num_words)
+                return false; // full
+
+            switch (settle(v, pending, mine)) {
+            case Outcome::lost:
+                return false;
+            case Outcome::retry:
+                continue;
+            case Outcome::won:
+                break;
+            }
+            commit(mine, pending, v);
+            return true;
+        }
+    }
+
+    /// Remove v. Returns true if this call removed it.
+    bool erase(uint64_t v) {
+        assert(v >= 1 && v <= max_safe_value);
+        for (std::size_t i = 0; i < num_words; ++i) {
+            uint64_t w = words_[i].load();
+            for (;;) {
+                uint64_t m = lanes_equal(w, v);
+                if (m == 0)
+                    break;
+                uint64_t cleared = w & ~Word::lanes_of(m & (0 - m));
+                if (words_[i].compare_exchange_weak(w, cleared))
+                    return true;
+                // w reloaded: the lane may have been erased meanwhile.
+            }
+        }
+        return false;
+    }
+
+    /// True if v is committed. Wait-free.
+    bool contains(uint64_t v) const {
+        assert(v >= 1 && v <= max_safe_value);
+        for (const auto &a : words_) {
+            if (lanes_equal(a.load(), v) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    /// Snapshot of word i (for inspection / benchmarking). Pending lanes
+    /// have their MSB set.
+    Word load_word(std::size_t i) const noexcept {
+        assert(i < num_words);
+        return Word(words_[i].load());
+    }
+
+    /// Fixed capacity of the set.
+    static constexpr std::size_t size() noexcept { return capacity; }
+
+    /// Number of words backing this set.
+    static constexpr std::size_t word_count() noexcept { return num_words; }
+
+  private:
+    static constexpr uint64_t pending_bit = uint64_t(1) << (N - 1);
+
+    struct Slot {
+        std::size_t word;
+        unsigned lane;
+        bool committed;
+    };
+
+    enum class Outcome { won, lost, retry };
+
+    /// MSB of each lane of w equal to x (all N bits compared).
+    static constexpr uint64_t lanes_equal(uint64_t w, uint64_t x) noexcept {
+        return Word(w ^ Word::broadcast(x).raw()).zero_lanes_mask();
+    }
+
+    static constexpr unsigned lane_of(uint64_t mask) noexcept {
+        return static_cast<unsigned>(__builtin_ctzll(mask)) / N;
+    }
+
+    /// First lane holding v committed, else first holding pending, else
+    /// {num_words}.
+    Slot find(uint64_t v, uint64_t pending) const noexcept {
+        Slot p{num_words, 0, false};
+        for (std::size_t i = 0; i < num_words; ++i) {
+            uint64_t w = words_[i].load();
+            if (uint64_t m = lanes_equal(w, v))
+                return {i, lane_of(m), true};
+            if (p.word == num_words) {
+                if (uint64_t m = lanes_equal(w, pending))
+                    p = {i, lane_of(m), false};
+            }
+        }
+        return p;
+    }
+
+    /// CAS pending into the first zero lane. {num_words} if every lane
+    /// is taken.
+    Slot claim(uint64_t pending) noexcept {
+        for (std::size_t i = 0; i < num_words; ++i) {
+            uint64_t w = words_[i].load();
+            for (;;) {
+                int lane = Word(w).find_zero();
+                if (lane < 0)
+                    break;
+                uint64_t claimed =
+                    w | (pending << (static_cast<unsigned>(lane) * N));
+                if (words_[i].compare_exchange_weak(w, claimed))
+                    return {i, static_cast<unsigned>(lane), false};
+            }
+        }
+        return {num_words, 0, false};
+    }
+
+    /// Resolve other copies of v against our pending claim in `mine`.
+    /// Waits out pending copies in higher slots; withdraws ours if v is
+    /// committed elsewhere (lost) or pending in a lower slot (retry).
+    Outcome settle(uint64_t v, uint64_t pending, Slot mine) noexcept {
+        const std::size_t my_slot = mine.word * lanes_per_word + mine.lane;
+        const uint64_t my_flag = uint64_t(1) << (mine.lane * N + N - 1);
+        for (std::size_t i = 0; i < num_words; ++i) {
+            uint64_t w = words_[i].load();
+            for (;;) {
+                if (lanes_equal(w, v) != 0) {
+                    withdraw(mine);
+                    return Outcome::lost;
+                }
+                uint64_t m = lanes_equal(w, pending);
+                if (i == mine.word)
+                    m &= ~my_flag;
+                if (m == 0)
+                    break;
+                std::size_t slot = i * lanes_per_word + lane_of(m);
+                if (slot < my_slot) {
+                    withdraw(mine);
+                    return Outcome::retry;
+                }
+                // A higher pending copy: its owner will see ours and
+                // withdraw, or has already passed us and will commit.
+                std::this_thread::yield();
+                w = words_[i].load();
+            }
+        }
+        return Outcome::won;
+    }
+
+    /// Clear the guard of our pending lane. Only the claiming thread
+    /// touches a pending lane, so this always lands; the loop only
+    /// absorbs updates to the word's other lanes.
+    void commit(Slot mine, uint64_t pending, uint64_t v) noexcept {
+        auto &a = words_[mine.word];
+        const uint64_t flip = (pending ^ v) << (mine.lane * N);
+        uint64_t w = a.load();
+        while (!a.compare_exchange_weak(w, w ^ flip)) {
+        }
+    }
+
+    /// Zero our pending lane.
+    void withdraw(Slot mine) noexcept {
+        auto &a = words_[mine.word];
+        const uint64_t lane = Word::lane_mask << (mine.lane * N);
+        uint64_t w = a.load();
+        while (!a.compare_exchange_weak(w, w & ~lane)) {
+        }
+    }
+
+    std::array<std::atomic<uint64_t>, num_words> words_;
+};
+
+} // namespace swar
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "dispatch.hpp"
+#include "packed_word.hpp"
+#include <array>
+
+namespace swar {
+
+/// A PackedSet variant that tracks its element count and which words
+/// still have a free lane.
+///
+/// Compared to PackedSet:
+///   - size() is the live element count; capacity is a hard limit, so a
+///     full set rejects inserts without touching the words.
+///   - insert is one pass: the duplicate scan covers only the words in
+///     use, and the first free slot comes from the free-word bitmap
+///     instead of a second find_zero scan.
+///   - contains/erase stop at the highest word ever written (used_words),
+///     so a lightly filled set with a large capacity scans a short prefix.
+///
+/// Stored values must be in [1, max_safe_value]; zero marks an empty lane.
+template <unsigned N, std::size_t Capacity>
+class CountedPackedSet {
+    static_assert(Capacity > 0, "Capacity must be > 0");
+
+  public:
+    using Word = PackedWord<N>;
+    static constexpr unsigned lanes_per_word = Word::lanes;
+    static constexpr std::size_t num_words =
+        (Capacity + lanes_per_word - 1) / lanes_per_word;
+    static constexpr std::size_t capacity = Capacity;
+
+    constexpr CountedPackedSet() noexcept
+        : words_{}, free_words_{}, size_(0), used_words_(0) {
+        for (std::size_t i = 0; i < num_words; ++i)
+            free_words_[i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    /// Insert a value. Returns true if inserted, false if already present
+    /// or the set holds Capacity elements.
+    bool insert(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        if (size_ == capacity)
+            return false;
+        if (find_word(v) != used_words_)
+            return false;
+        std::size_t wi = first_free_word();
+        auto &w = words_[wi];
+        w = w.set(static_cast<unsigned>(w.find_zero()), v);
+        if (w.find_zero() < 0)
+            free_words_[wi / 64] &= ~(uint64_t(1) << (wi % 64));
+        if (wi >= used_words_)
+            used_words_ = wi + 1;
+        ++size_;
+        return true;
+    }
+
+    /// Remove a value. Returns true if it was present.
+    bool erase(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        std::size_t wi = find_word(v);
+        if (wi == used_words_)
+            return false;
+        auto &w = words_[wi];
+        w = w.set(static_cast<unsigned>(w.find(v)), 0);
+        free_words_[wi / 64] |= uint64_t(1) << (wi % 64);
+        while (used_words_ > 0 && words_[used_words_ - 1].raw() == 0)
+            --used_words_;
+        --size_;
+        return true;
+    }
+
+    /// Check if the set contains value v.
+    bool contains(uint64_t v) const {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        return find_word(v) != used_words_;
+    }
+
+    /// Number of elements currently stored.
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    bool full() const noexcept { return size_ == capacity; }
+
+    /// Words up to and including the highest one holding a value.
+    std::size_t used_words() const noexcept { return used_words_; }
+
+    /// Number of PackedWords backing this set.
+    static constexpr std::size_t word_count() noexcept { return num_words; }
+
+    /// Direct access to underlying words (for inspection / benchmarking).
+    const std::array<Word, num_words> &words() const noexcept {
+        return words_;
+    }
+
+  private:
+    static constexpr std::size_t bitmap_words = (num_words + 63) / 64;
+
+    /// First word of the used prefix holding v, or used_words_.
+    std::size_t find_word(uint64_t v) const noexcept {
+        return scan_words_prefix<N, num_words>(words_.data(), used_words_, v);
+    }
+
+    /// Lowest-index word with a free lane. Only called when size_ <
+    /// capacity, which guarantees one exists.
+    std::size_t first_free_word() const noexcept {
+        for (std::size_t i = 0; i < bitmap_words; ++i) {
+            if (free_words_[i] != 0)
+                return i * 64 +
+                       static_cast<std::size_t>(__builtin_ctzll(free_words_[i]));
+        }
+        assert(false && "no free word below capacity");
+        return 0;
+    }
+
+    std::array<Word, num_words> words_;
+    /// Bit i set if words_[i] has at least one zero lane.
+    std::array<uint64_t, bitmap_words> free_words_;
+    std::size_t size_;
+    std::size_t used_words_;
+};
+
+} // namespace swar
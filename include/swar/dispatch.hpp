@@ -0,0 +1,238 @@
+#pragma once
+
+#include "word_scan.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace swar {
+
+/// Runtime CPU dispatch for the scan kernels in word_scan.hpp.
+///
+/// The widest backend the CPU supports is detected once (cpuid via
+/// __builtin_cpu_supports) and each kernel family caches a function
+/// pointer to its implementation on first use. Containers only go through
+/// the pointer when built with SWAR_RUNTIME_DISPATCH (SWAR_SIMD=dispatch
+/// in CMake) and when they span at least dispatch_min_words words, so the
+/// small-set hot path stays an inlined scalar loop.
+///
+/// force_*_backend() re-points a kernel family at a lower tier, for
+/// benchmarking each tier on the same machine. The kernel pointers are
+/// atomics read with relaxed loads, so force_* may be called while other
+/// threads scan: each scan runs either the old kernel or the new one, and
+/// all tiers return the same result.
+
+/// Sets smaller than this many words skip dispatch: the indirect call
+/// costs more than a vector step saves.
+inline constexpr std::size_t dispatch_min_words = 4;
+
+/// Widest scan backend supported by the running CPU.
+inline ScanBackend detect_scan_backend() noexcept {
+#if SWAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return ScanBackend::avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return ScanBackend::avx2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return ScanBackend::sse42;
+#endif
+    return ScanBackend::scalar;
+}
+
+/// detect_scan_backend(), evaluated once per process.
+inline ScanBackend cpu_scan_backend() noexcept {
+    static const ScanBackend backend = detect_scan_backend();
+    return backend;
+}
+
+// ----- word scan (PackedSet) -----
+
+template <unsigned N>
+using WordScanFn = std::size_t (*)(const PackedWord<N> *, std::size_t,
+                                   uint64_t) noexcept;
+
+template <unsigned N>
+inline std::size_t scan_first_word_scalar_all(const PackedWord<N> *words,
+                                              std::size_t n,
+                                              uint64_t v) noexcept {
+    return scan_first_word_scalar(words, 0, n, v);
+}
+
+/// Word scan kernel for backend b. b must be supported by the CPU.
+template <unsigned N>
+inline WordScanFn<N> word_scan_kernel(ScanBackend b) noexcept {
+    switch (b) {
+#if SWAR_X86
+    case ScanBackend::avx512:
+        return &scan_first_word_avx512<N>;
+    case ScanBackend::avx2:
+        return &scan_first_word_avx2<N>;
+    case ScanBackend::sse42:
+        return &scan_first_word_sse42<N>;
+#endif
+    default:
+        return &scan_first_word_scalar_all<N>;
+    }
+}
+
+template <unsigned N>
+inline std::atomic<WordScanFn<N>> &word_scan_slot() noexcept {
+    static std::atomic<WordScanFn<N>> fn{
+        word_scan_kernel<N>(cpu_scan_backend())};
+    return fn;
+}
+
+/// Index of the first word with a lane equal to v, or n, using the
+/// backend selected at runtime.
+template <unsigned N>
+inline std::size_t scan_first_word_dispatch(const PackedWord<N> *words,
+                                            std::size_t n,
+                                            uint64_t v) noexcept {
+    return word_scan_slot<N>().load(std::memory_order_relaxed)(words, n, v);
+}
+
+/// Point the PackedWord<N> scan at backend b. Returns false (and changes
+/// nothing) if the CPU does not support b.
+template <unsigned N> inline bool force_word_scan_backend(ScanBackend b) {
+    if (b > cpu_scan_backend())
+        return false;
+    word_scan_slot<N>().store(word_scan_kernel<N>(b),
+                              std::memory_order_relaxed);
+    return true;
+}
+
+// ----- bucket scan (BucketedSet) -----
+
+using BucketScanFn = std::size_t (*)(const uint64_t *, std::size_t,
+                                     uint64_t) noexcept;
+
+template <class L>
+inline std::size_t scan_first_bucket_scalar_all(const uint64_t *buckets,
+                                                std::size_t n,
+                                                uint64_t lo) noexcept {
+    return scan_first_bucket_scalar<L>(buckets, 0, n, lo);
+}
+
+/// Bucket scan kernel for layout L and backend b.
+template <class L>
+inline BucketScanFn bucket_scan_kernel(ScanBackend b) noexcept {
+    switch (b) {
+#if SWAR_X86
+    case ScanBackend::avx512:
+        return &scan_first_bucket_avx512<L>;
+    case ScanBackend::avx2:
+        return &scan_first_bucket_avx2<L>;
+    case ScanBackend::sse42:
+        return &scan_first_bucket_sse42<L>;
+#endif
+    default:
+        return &scan_first_bucket_scalar_all<L>;
+    }
+}
+
+template <class L>
+inline std::atomic<BucketScanFn> &bucket_scan_slot() noexcept {
+    static std::atomic<BucketScanFn> fn{
+        bucket_scan_kernel<L>(cpu_scan_backend())};
+    return fn;
+}
+
+/// Index of the first bucket with an occupied lane equal to lo, or n,
+/// using the backend selected at runtime.
+template <class L>
+inline std::size_t scan_first_bucket_dispatch(const uint64_t *buckets,
+                                              std::size_t n,
+                                              uint64_t lo) noexcept {
+    return bucket_scan_slot<L>().load(std::memory_order_relaxed)(buckets, n,
+                                                                 lo);
+}
+
+/// Point the layout-L bucket scan at backend b. Returns false (and changes
+/// nothing) if the CPU does not support b.
+template <class L> inline bool force_bucket_scan_backend(ScanBackend b) {
+    if (b > cpu_scan_backend())
+        return false;
+    bucket_scan_slot<L>().store(bucket_scan_kernel<L>(b),
+                                std::memory_order_relaxed);
+    return true;
+}
+
+// ----- fixed-size entry points used by the containers -----
+
+/// First word of words[0, Words) with a lane equal to v, or Words.
+/// Dispatches at runtime only under SWAR_RUNTIME_DISPATCH and for sets of
+/// at least dispatch_min_words words; otherwise uses scan_first_word.
+template <unsigned N, std::size_t Words>
+inline std::size_t scan_words(const PackedWord<N> *words,
+                              uint64_t v) noexcept {
+#if defined(SWAR_RUNTIME_DISPATCH)
+    if constexpr (Words >= dispatch_min_words)
+        return scan_first_word_dispatch(words, Words, v);
+#endif
+    return scan_first_word(words, Words, v);
+}
+
+/// Same as above for a word count only known at runtime.
+template <unsigned N>
+inline std::size_t scan_words(const PackedWord<N> *words, std::size_t n,
+                              uint64_t v) noexcept {
+#if defined(SWAR_RUNTIME_DISPATCH)
+    if (n >= dispatch_min_words)
+        return scan_first_word_dispatch(words, n, v);
+#endif
+    return scan_first_word(words, n, v);
+}
+
+/// ExactZero words: the vector kernels rely on the guard bit, so these
+/// scan with the exact per-word test.
+template <unsigned N, std::size_t Words>
+inline std::size_t scan_words(const PackedWord<N, ExactZero> *words,
+                              uint64_t v) noexcept {
+    for (std::size_t i = 0; i < Words; ++i) {
+        if (words[i].contains(v))
+            return i;
+    }
+    return Words;
+}
+
+template <unsigned N>
+inline std::size_t scan_words(const PackedWord<N, ExactZero> *words,
+                              std::size_t n, uint64_t v) noexcept {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (words[i].contains(v))
+            return i;
+    }
+    return n;
+}
+
+/// First word of words[0, n) with a lane equal to v, or n, for a runtime
+/// n of at most Words (the used prefix of a Words-word set). A set smaller
+/// than one vector step scans all Words words on the fixed-size path and
+/// clamps the result; a hit past n only ever comes after the first hit
+/// below it. Either way the compiler can see no load leaves the set,
+/// which the plain runtime-length scan hides from -Warray-bounds.
+template <unsigned N, std::size_t Words, class ZeroTest>
+inline std::size_t scan_words_prefix(const PackedWord<N, ZeroTest> *words,
+                                     std::size_t n, uint64_t v) noexcept {
+    assert(n <= Words);
+    if constexpr (Words < scan_step_words)
+        return std::min(scan_words<N, Words>(words, v), n);
+    else
+        return scan_words(words, std::min(n, Words), v);
+}
+
+/// First bucket of buckets[0, Buckets) holding lo, or Buckets. Same
+/// dispatch policy as scan_words.
+template <class L, std::size_t Buckets>
+inline std::size_t scan_buckets(const uint64_t *buckets,
+                                uint64_t lo) noexcept {
+#if defined(SWAR_RUNTIME_DISPATCH)
+    if constexpr (Buckets >= dispatch_min_words)
+        return scan_first_bucket_dispatch<L>(buckets, Buckets, lo);
+#endif
+    return scan_first_bucket<L>(buckets, Buckets, lo);
+}
+
+} // namespace swar
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "packed_word.hpp"
+#include <array>
+#include <cstddef>
+
+namespace swar {
+
+/// An open-addressing hash set of N-bit integers whose probe unit is a
+/// whole PackedWord<N> group, in the style of Swiss tables.
+///
+/// A multiplicative hash picks a home group; lookups test the group with
+/// PackedWord::contains and move to the next group (linear probing) only
+/// while the group's overflow count is non-zero. overflow_[g] counts the
+/// values that were inserted past group g because it was full, so a
+/// lookup stops at the first group nobody overflowed. erase decrements
+/// the counts along the value's probe path; a count that reached 255
+/// saturates and stays, which only costs extra probes.
+///
+/// The group count is the power of two that keeps the load factor at or
+/// below 7/8 of the lanes at full Capacity. As with PackedSet, zero marks
+/// an empty lane, so stored values must be in [1, max_safe_value].
+template <unsigned N, std::size_t Capacity>
+class PackedHashSet {
+    static_assert(Capacity > 0, "Capacity must be > 0");
+
+  public:
+    using Word = PackedWord<N>;
+    static constexpr unsigned lanes_per_word = Word::lanes;
+    static constexpr std::size_t capacity = Capacity;
+
+  private:
+    static constexpr std::size_t min_groups =
+        (Capacity * 8 / 7 + lanes_per_word) / lanes_per_word;
+    static constexpr unsigned group_bits = [] {
+        unsigned bits = 0;
+        while ((std::size_t(1) << bits) < min_groups)
+            ++bits;
+        return bits;
+    }();
+
+  public:
+    static constexpr std::size_t num_groups = std::size_t(1) << group_bits;
+
+    constexpr PackedHashSet() noexcept : groups_{}, overflow_{}, size_(0) {}
+
+    /// Insert a value. Returns true if inserted, false if already present
+    /// or the set holds Capacity elements.
+    bool insert(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        if (contains(v) || size_ == capacity)
+            return false;
+        std::size_t g = home(v);
+        for (;;) {
+            auto &w = groups_[g];
+            int lane = w.find_zero();
+            if (lane >= 0) {
+                w = w.set(static_cast<unsigned>(lane), v);
+                ++size_;
+                return true;
+            }
+            if (overflow_[g] != 0xFF)
+                ++overflow_[g];
+            g = (g + 1) & (num_groups - 1);
+        }
+    }
+
+    /// Remove a value. Returns true if it was present.
+    bool erase(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        std::size_t g = home(v);
+        for (std::size_t probes = 0; probes < num_groups; ++probes) {
+            auto &w = groups_[g];
+            int lane = w.find(v);
+            if (lane >= 0) {
+                w = w.set(static_cast<unsigned>(lane), 0);
+                for (std::size_t p = home(v); p != g;
+                     p = (p + 1) & (num_groups - 1)) {
+                    if (overflow_[p] != 0xFF)
+                        --overflow_[p];
+                }
+                --size_;
+                return true;
+            }
+            if (overflow_[g] == 0)
+                return false;
+            g = (g + 1) & (num_groups - 1);
+        }
+        return false;
+    }
+
+    /// Check if the set contains value v.
+    bool contains(uint64_t v) const {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        std::size_t g = home(v);
+        for (std::size_t probes = 0; probes < num_groups; ++probes) {
+            if (groups_[g].contains(v))
+                return true;
+            if (overflow_[g] == 0)
+                return false;
+            g = (g + 1) & (num_groups - 1);
+        }
+        return false;
+    }
+
+    /// Number of elements currently stored.
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /// Number of PackedWord groups backing this set.
+    static constexpr std::size_t group_count() noexcept { return num_groups; }
+
+    /// Direct access to underlying groups (for inspection / benchmarking).
+    const std::array<Word, num_groups> &groups() const noexcept {
+        return groups_;
+    }
+
+  private:
+    /// Home group: top group_bits bits of a Fibonacci hash of v.
+    static constexpr std::size_t home(uint64_t v) noexcept {
+        if constexpr (group_bits == 0)
+            return 0;
+        else
+            return static_cast<std::size_t>((v * 0x9E3779B97F4A7C15ULL) >>
+                                            (64 - group_bits));
+    }
+
+    std::array<Word, num_groups> groups_;
+    /// Values that probed past each group because it was full (saturating).
+    std::array<uint8_t, num_groups> overflow_;
+    std::size_t size_;
+};
+
+} // namespace swar
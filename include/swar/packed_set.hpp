@@ -1,29 +1,67 @@
 #pragma once
 
+#include "dispatch.hpp"
 #include "packed_word.hpp"
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 
 namespace swar {
 
+/// Erase policies for PackedSet.
+///
+/// EraseInPlace zeroes the erased lane and leaves the hole for a later
+/// insert; lookups scan every word.
+struct EraseInPlace {};
+
+/// EraseCompact moves the last stored value into the erased lane, so the
+/// values always fill slots [0, count) (slot i is word i / lanes_per_word,
+/// lane i % lanes_per_word), like BucketedSet's swap-with-last. The set
+/// keeps the slot count, inserts append at it, and lookups stop after the
+/// last word holding a value.
+struct EraseCompact {};
+
+namespace detail {
+
+/// Per-set state an erase policy needs: none for EraseInPlace.
+template <class Erase> struct PackedSetState {};
+
+template <> struct PackedSetState<EraseCompact> {
+    std::size_t count_ = 0;
+};
+
+} // namespace detail
+
 /// A fixed-capacity set of N-bit integers, stored as a compile-time-sized
 /// array of PackedWord<N> instances. Capacity is the maximum number of
 /// elements the set can hold.
 ///
 /// Each word holds up to PackedWord<N>::lanes elements. Empty lanes are
 /// represented by zero, so stored values must be in [1, max_safe_value].
+/// ZeroTest picks the PackedWord search policy: GuardedZero keeps the
+/// vector scan kernels; ExactZero allows values up to 2^N - 1 (2047 at
+/// N=11) and scans with the exact per-word test. Erase picks what erase
+/// does with the hole it leaves (EraseInPlace or EraseCompact above).
 ///
 /// This is a simple flat container — not hash-based, not sorted.
 /// Suitable for small sets where SWAR search is fast enough.
-template <unsigned N, std::size_t Capacity>
-class PackedSet {
+template <unsigned N, std::size_t Capacity, class ZeroTest = GuardedZero,
+          class Erase = EraseInPlace>
+class PackedSet : private detail::PackedSetState<Erase> {
     static_assert(Capacity > 0, "Capacity must be > 0");
+    static_assert(std::is_same_v<Erase, EraseInPlace> ||
+                      std::is_same_v<Erase, EraseCompact>,
+                  "Erase must be EraseInPlace or EraseCompact");
 
   public:
-    using Word = PackedWord<N>;
+    using Word = PackedWord<N, ZeroTest>;
     static constexpr unsigned lanes_per_word = Word::lanes;
     static constexpr std::size_t num_words =
         (Capacity + lanes_per_word - 1) / lanes_per_word;
     static constexpr std::size_t capacity = Capacity;
+    static constexpr bool compacting = std::is_same_v<Erase, EraseCompact>;
 
     constexpr PackedSet() noexcept : words_{} {}
 
@@ -34,6 +72,15 @@ class PackedSet {
         assert(v >= 1 && v <= Word::max_safe_value);
         if (contains(v))
             return false;
+        if constexpr (compacting) {
+            std::size_t &count = this->count_;
+            if (count == capacity)
+                return false;
+            auto &w = words_[count / lanes_per_word];
+            w = w.set(static_cast<unsigned>(count % lanes_per_word), v);
+            ++count;
+            return true;
+        }
         for (auto &w : words_) {
             int idx = w.find_zero();
             if (idx >= 0) {
@@ -46,26 +93,294 @@ class PackedSet {
     }
 
     /// Remove a value from the set. Returns true if it was present.
+    /// Under EraseCompact the last stored value moves into its lane.
     bool erase(uint64_t v) {
         assert(v >= 1 && v <= Word::max_safe_value);
-        for (auto &w : words_) {
-            int idx = w.find(v);
-            if (idx >= 0) {
-                w = w.set(static_cast<unsigned>(idx), 0);
-                return true;
-            }
+        std::size_t wi = find_word(v);
+        if (wi == live_words())
+            return false;
+        auto &w = words_[wi];
+        unsigned lane = static_cast<unsigned>(w.find(v));
+        if constexpr (compacting) {
+            std::size_t last = --this->count_;
+            auto &lw = words_[last / lanes_per_word];
+            unsigned ll = static_cast<unsigned>(last % lanes_per_word);
+            // Fill the hole first: if v was the last value, the clear
+            // below removes it.
+            w = w.set(lane, lw.get(ll));
+            lw = lw.set(ll, 0);
+        } else {
+            w = w.set(lane, 0);
         }
-        return false;
+        return true;
     }
 
     /// Check if the set contains value v.
+    /// Scans with the compile-time or runtime-dispatched vector backend
+    /// (see word_scan.hpp and dispatch.hpp).
     bool contains(uint64_t v) const {
         assert(v >= 1 && v <= Word::max_safe_value);
+        return find_word(v) != live_words();
+    }
+
+    /// Words lookups scan: num_words under EraseInPlace; under
+    /// EraseCompact, the words holding the first count() slots.
+    std::size_t live_words() const noexcept {
+        if constexpr (compacting)
+            return (this->count_ + lanes_per_word - 1) / lanes_per_word;
+        else
+            return num_words;
+    }
+
+    /// Number of stored values. EraseCompact only: an EraseInPlace set
+    /// does not track it.
+    std::size_t live_count() const noexcept {
+        static_assert(compacting, "only EraseCompact sets track a count");
+        return this->count_;
+    }
+
+    /// Number of stored values in [lo, hi]. Empty lanes hold zero, which
+    /// is never a stored value, so lo is raised to 1.
+    std::size_t count_in_range(uint64_t lo, uint64_t hi) const {
+        assert(lo <= Word::max_safe_value && hi <= Word::max_safe_value);
+        lo = std::max<uint64_t>(lo, 1);
+        std::size_t n = 0;
+        for (const auto &w : words_)
+            n += Word::count_lanes(w.in_range_mask(lo, hi));
+        return n;
+    }
+
+    // ----- set algebra -----
+    // Word at a time: each word of one set is matched against every word
+    // of the other with PackedWord::match_any_mask, which yields the lanes
+    // present in the other set without extracting them. Lanes dropped from
+    // a result are zeroed in place, like erase; EraseCompact results are
+    // then packed back into slots [0, count) with PackedWord::compress.
+
+    /// Same word layout and policies, any capacity.
+    template <std::size_t C2>
+    using Like = PackedSet<N, C2, ZeroTest, Erase>;
+
+    /// MSB of each non-empty lane of w whose value is in this set.
+    uint64_t member_lanes(const Word &w) const {
+        uint64_t want = occupied_lanes(w);
+        uint64_t m = 0;
+        for (std::size_t i = 0, n = live_words(); i < n; ++i) {
+            m |= w.match_any_mask(words_[i]);
+            if (m == want)
+                break;
+        }
+        return m;
+    }
+
+    /// Number of values in both this set and o.
+    template <std::size_t C2>
+    std::size_t intersection_size(const Like<C2> &o) const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < live_words(); ++i)
+            n += Word::count_lanes(o.member_lanes(words_[i]));
+        return n;
+    }
+
+    /// True if every value of this set is in o.
+    template <std::size_t C2>
+    bool is_subset_of(const Like<C2> &o) const {
+        for (std::size_t i = 0; i < live_words(); ++i) {
+            if (o.member_lanes(words_[i]) != occupied_lanes(words_[i]))
+                return false;
+        }
+        return true;
+    }
+
+    /// Values in both this set and o.
+    template <std::size_t C2>
+    PackedSet intersect(const Like<C2> &o) const {
+        PackedSet r;
+        for (std::size_t i = 0; i < live_words(); ++i)
+            r.words_[i] = Word(words_[i].raw() &
+                               Word::lanes_of(o.member_lanes(words_[i])));
+        r.pack();
+        return r;
+    }
+
+    /// Values in this set but not in o.
+    template <std::size_t C2>
+    PackedSet difference(const Like<C2> &o) const {
+        PackedSet r;
+        for (std::size_t i = 0; i < live_words(); ++i)
+            r.words_[i] = Word(words_[i].raw() &
+                               ~Word::lanes_of(o.member_lanes(words_[i])));
+        r.pack();
+        return r;
+    }
+
+    /// Values in either set. The result has room for every word of both
+    /// operands: this set's words, then o's words minus the shared values.
+    template <std::size_t C2>
+    Like<(num_words + Like<C2>::num_words) * lanes_per_word>
+    unite(const Like<C2> &o) const {
+        Like<(num_words + Like<C2>::num_words) * lanes_per_word> r;
+        for (std::size_t i = 0; i < num_words; ++i)
+            r.words_[i] = words_[i];
+        for (std::size_t i = 0; i < o.live_words(); ++i) {
+            const Word &w = o.words()[i];
+            r.words_[num_words + i] =
+                Word(w.raw() & ~Word::lanes_of(member_lanes(w)));
+        }
+        r.pack();
+        return r;
+    }
+
+    // ----- batched lookups -----
+
+    /// Number of needles tested together per pass over the words.
+    static constexpr std::size_t batch_width = 4;
+
+    /// out[i] = contains(needles[i]) for i in [0, count).
+    /// Each word is loaded once per group of batch_width needles, and the
+    /// haszero tests for the group are independent so they can overlap.
+    void contains_many(const uint64_t *needles, std::size_t count,
+                       bool *out) const {
+        std::size_t i = 0;
+        for (; i + batch_width <= count; i += batch_width) {
+            uint64_t bcast[batch_width];
+            uint64_t hits[batch_width] = {};
+            for (std::size_t k = 0; k < batch_width; ++k) {
+                assert(needles[i + k] >= 1 &&
+                       needles[i + k] <= Word::max_safe_value);
+                bcast[k] = Word::broadcast(needles[i + k]).raw();
+            }
+            for (std::size_t wi = 0, n = live_words(); wi < n; ++wi) {
+                bool all_found = true;
+                for (std::size_t k = 0; k < batch_width; ++k) {
+                    hits[k] |= Word(words_[wi].raw() ^ bcast[k])
+                                   .zero_lanes_mask();
+                    all_found &= hits[k] != 0;
+                }
+                if (all_found)
+                    break;
+            }
+            for (std::size_t k = 0; k < batch_width; ++k)
+                out[i + k] = hits[k] != 0;
+        }
+        for (; i < count; ++i)
+            out[i] = contains(needles[i]);
+    }
+
+    /// out[i] = slot index (word * lanes_per_word + lane) holding
+    /// needles[i], or -1 if absent. Same batching as contains_many.
+    void find_many(const uint64_t *needles, std::size_t count,
+                   int *out) const {
+        std::size_t i = 0;
+        for (; i < count; i += batch_width) {
+            std::size_t group = std::min(batch_width, count - i);
+            uint64_t bcast[batch_width];
+            int slots[batch_width];
+            for (std::size_t k = 0; k < group; ++k) {
+                assert(needles[i + k] >= 1 &&
+                       needles[i + k] <= Word::max_safe_value);
+                bcast[k] = Word::broadcast(needles[i + k]).raw();
+                slots[k] = -1;
+            }
+            for (std::size_t wi = 0, n = live_words(); wi < n; ++wi) {
+                bool all_found = true;
+                for (std::size_t k = 0; k < group; ++k) {
+                    uint64_t mask =
+                        Word(words_[wi].raw() ^ bcast[k]).zero_lanes_mask();
+                    if (slots[k] < 0 && mask != 0)
+                        slots[k] = static_cast<int>(
+                            wi * lanes_per_word + __builtin_ctzll(mask) / N);
+                    all_found &= slots[k] >= 0;
+                }
+                if (all_found)
+                    break;
+            }
+            for (std::size_t k = 0; k < group; ++k)
+                out[i + k] = slots[k];
+        }
+    }
+
+    // ----- iteration -----
+    // Stored values are visited word by word, lanes in ascending order;
+    // the occupied lanes of a word are the complement of its
+    // zero_lanes_mask, walked with a ctz loop. Order is storage order,
+    // not value order, and is unspecified across insert/erase.
+
+    /// Call f(v) for every stored value.
+    template <class F> void for_each(F f) const {
         for (const auto &w : words_) {
-            if (w.contains(v))
-                return true;
+            uint64_t x = w.raw();
+            for (uint64_t m = occupied_lanes(w); m != 0; m &= m - 1)
+                f((x >> lane_shift(m)) & Word::lane_mask);
         }
-        return false;
+    }
+
+    /// Forward iterator over the stored values. Dereferences to the value
+    /// itself (there is no stored object to refer to). Invalidated by any
+    /// insert or erase.
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t *;
+        using reference = uint64_t;
+
+        const_iterator() noexcept = default;
+
+        uint64_t operator*() const noexcept {
+            return (set_->words_[wi_].raw() >> lane_shift(lanes_)) &
+                   Word::lane_mask;
+        }
+
+        const_iterator &operator++() noexcept {
+            lanes_ &= lanes_ - 1;
+            if (lanes_ == 0)
+                seek(wi_ + 1);
+            return *this;
+        }
+        const_iterator operator++(int) noexcept {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator &a,
+                               const const_iterator &b) noexcept {
+            return a.wi_ == b.wi_ && a.lanes_ == b.lanes_;
+        }
+        friend bool operator!=(const const_iterator &a,
+                               const const_iterator &b) noexcept {
+            return !(a == b);
+        }
+
+      private:
+        friend class PackedSet;
+
+        const_iterator(const PackedSet *set, std::size_t wi) noexcept
+            : set_(set) {
+            seek(wi);
+        }
+
+        /// Move to the first occupied lane in words [wi, num_words).
+        void seek(std::size_t wi) noexcept {
+            for (; wi < num_words; ++wi) {
+                lanes_ = occupied_lanes(set_->words_[wi]);
+                if (lanes_ != 0)
+                    break;
+            }
+            wi_ = wi;
+        }
+
+        const PackedSet *set_ = nullptr;
+        std::size_t wi_ = num_words;
+        uint64_t lanes_ = 0; // occupied lanes of word wi_ not yet visited
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept {
+        return const_iterator(this, num_words);
     }
 
     /// Fixed capacity of the set.
@@ -80,6 +395,51 @@ class PackedSet {
     }
 
   private:
+    template <unsigned, std::size_t, class, class> friend class PackedSet;
+
+    /// First word holding v, or live_words().
+    std::size_t find_word(uint64_t v) const noexcept {
+        if constexpr (compacting)
+            return scan_words_prefix<N, num_words>(words_.data(),
+                                                   live_words(), v);
+        else
+            return scan_words<N, num_words>(words_.data(), v);
+    }
+
+    /// EraseCompact: slide the stored values down into slots [0, count),
+    /// keeping their order, and set the count. No-op for EraseInPlace.
+    void pack() noexcept {
+        if constexpr (compacting) {
+            std::array<Word, num_words> out{};
+            std::size_t n = 0;
+            for (const auto &w : words_) {
+                uint64_t m = occupied_lanes(w);
+                if (m == 0)
+                    continue;
+                uint64_t c = w.compress(m).raw();
+                std::size_t wi = n / lanes_per_word;
+                unsigned at = static_cast<unsigned>(n % lanes_per_word);
+                out[wi] = Word(out[wi].raw() |
+                               ((c << (at * N)) & Word::all_lanes_mask));
+                if (at != 0 && wi + 1 < num_words)
+                    out[wi + 1] = Word(c >> ((lanes_per_word - at) * N));
+                n += Word::count_lanes(m);
+            }
+            words_ = out;
+            this->count_ = n;
+        }
+    }
+
+    /// MSB of each non-empty lane of w.
+    static constexpr uint64_t occupied_lanes(const Word &w) noexcept {
+        return ~w.zero_lanes_mask() & Word::high_bits;
+    }
+
+    /// Bit offset of the lane flagged by the lowest set bit of m.
+    static constexpr unsigned lane_shift(uint64_t m) noexcept {
+        return static_cast<unsigned>(__builtin_ctzll(m)) - (N - 1);
+    }
+
     std::array<Word, num_words> words_;
 };
 
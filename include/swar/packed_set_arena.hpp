@@ -0,0 +1,191 @@
+#pragma once
+
+#include "dispatch.hpp"
+#include "packed_set.hpp"
+#include "packed_word.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace swar {
+
+/// Minimal allocator handing out 64-byte-aligned storage, so a stride that
+/// divides (or is a multiple of) the cache line keeps every set inside
+/// its own line(s).
+template <class T> struct CacheLineAllocator {
+    using value_type = T;
+    static constexpr std::size_t alignment = 64;
+
+    CacheLineAllocator() = default;
+    template <class U>
+    CacheLineAllocator(const CacheLineAllocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(
+            ::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+    void deallocate(T *p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    template <class U>
+    bool operator==(const CacheLineAllocator<U> &) const noexcept {
+        return true;
+    }
+    template <class U>
+    bool operator!=(const CacheLineAllocator<U> &) const noexcept {
+        return false;
+    }
+};
+
+/// Many PackedSet<N, Capacity> stored back to back in one allocation and
+/// addressed by integer handle.
+///
+/// Set h occupies words [h * stride, h * stride + words_per_set). With
+/// AlignStride = false the stride is words_per_set, the densest layout.
+/// With AlignStride = true it is rounded up to a power of two (below one
+/// cache line) or a whole number of lines, so no set straddles a line
+/// boundary and a lookup costs exactly one miss per line of the set.
+///
+/// Lookups run the same scan as PackedSet; contains_many adds software
+/// prefetch prefetch_distance entries ahead, for bulk random access
+/// across sets that do not fit in cache.
+template <unsigned N, std::size_t Capacity, bool AlignStride = false>
+class PackedSetArena {
+  public:
+    using Set = PackedSet<N, Capacity>;
+    using Word = PackedWord<N>;
+    using handle = uint32_t;
+
+    static constexpr unsigned lanes_per_word = Word::lanes;
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr std::size_t words_per_set = Set::num_words;
+    static constexpr std::size_t words_per_line =
+        CacheLineAllocator<Word>::alignment / sizeof(Word);
+    static constexpr std::size_t stride = [] {
+        if (!AlignStride)
+            return words_per_set;
+        if (words_per_set >= words_per_line)
+            return (words_per_set + words_per_line - 1) / words_per_line *
+                   words_per_line;
+        std::size_t s = 1;
+        while (s < words_per_set)
+            s *= 2;
+        return s;
+    }();
+
+    /// How many handles ahead contains_many prefetches.
+    static constexpr std::size_t prefetch_distance = 8;
+
+    PackedSetArena() = default;
+
+    /// An arena holding `sets` empty sets, with handles [0, sets).
+    explicit PackedSetArena(std::size_t sets) { resize(sets); }
+
+    /// Append an empty set and return its handle.
+    handle create() {
+        handle h = static_cast<handle>(set_count());
+        words_.resize(words_.size() + stride);
+        return h;
+    }
+
+    /// Grow or shrink to `sets` sets; new sets are empty.
+    void resize(std::size_t sets) { words_.resize(sets * stride); }
+
+    /// Reserve storage for `sets` sets without creating them.
+    void reserve(std::size_t sets) { words_.reserve(sets * stride); }
+
+    /// Number of sets in the arena.
+    std::size_t set_count() const noexcept { return words_.size() / stride; }
+
+    /// Bytes of word storage per set (including stride padding).
+    static constexpr std::size_t bytes_per_set() noexcept {
+        return stride * sizeof(Word);
+    }
+
+    /// Insert v into set h. Returns true if inserted, false if already
+    /// present or the set is full.
+    bool insert(handle h, uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        if (contains(h, v))
+            return false;
+        Word *w = set_words(h);
+        for (std::size_t i = 0; i < words_per_set; ++i) {
+            int idx = w[i].find_zero();
+            if (idx >= 0) {
+                w[i] = w[i].set(static_cast<unsigned>(idx), v);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Remove v from set h. Returns true if it was present.
+    bool erase(handle h, uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        Word *w = set_words(h);
+        std::size_t wi = scan_words<N, words_per_set>(w, v);
+        if (wi == words_per_set)
+            return false;
+        w[wi] = w[wi].set(static_cast<unsigned>(w[wi].find(v)), 0);
+        return true;
+    }
+
+    /// Check if set h contains v.
+    bool contains(handle h, uint64_t v) const {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        return scan_words<N, words_per_set>(set_words(h), v) != words_per_set;
+    }
+
+    /// Empty set h.
+    void clear(handle h) noexcept {
+        Word *w = set_words(h);
+        for (std::size_t i = 0; i < words_per_set; ++i)
+            w[i] = Word();
+    }
+
+    /// out[i] = contains(handles[i], values[i]) for i in [0, count).
+    /// Prefetches the set prefetch_distance lookups ahead so the cache
+    /// misses of independent lookups overlap.
+    void contains_many(const handle *handles, const uint64_t *values,
+                       std::size_t count, bool *out) const {
+        std::size_t ahead = std::min(prefetch_distance, count);
+        for (std::size_t i = 0; i < ahead; ++i)
+            prefetch(handles[i]);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i + prefetch_distance < count)
+                prefetch(handles[i + prefetch_distance]);
+            out[i] = contains(handles[i], values[i]);
+        }
+    }
+
+    /// Words of set h (words_per_set of them).
+    const Word *set_words(handle h) const noexcept {
+        assert(h < set_count());
+        return words_.data() + std::size_t(h) * stride;
+    }
+    Word *set_words(handle h) noexcept {
+        assert(h < set_count());
+        return words_.data() + std::size_t(h) * stride;
+    }
+
+  private:
+    void prefetch(handle h) const noexcept {
+        const Word *w = set_words(h);
+        for (std::size_t i = 0; i < words_per_set; i += words_per_line)
+            __builtin_prefetch(w + i);
+        // An unaligned set may spill into one more line.
+        if constexpr (!AlignStride && words_per_set > 1) {
+            const Word *last = w + words_per_set - 1;
+            if ((reinterpret_cast<uintptr_t>(w) ^
+                 reinterpret_cast<uintptr_t>(last)) >=
+                CacheLineAllocator<Word>::alignment)
+                __builtin_prefetch(last);
+        }
+    }
+
+    std::vector<Word, CacheLineAllocator<Word>> words_;
+};
+
+} // namespace swar
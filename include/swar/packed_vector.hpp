@@ -0,0 +1,275 @@
+#pragma once
+
+#include "vector_scan.hpp"
+#include "word_scan.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "PackedVector reads its bit stream with unaligned byte loads");
+
+namespace swar {
+
+// ----- bulk unpack kernels -----
+//
+// A group is 8 consecutive N-bit values: 8N bits, exactly N bytes, so
+// every group starts on a byte boundary and value k of a group sits at
+// the fixed byte k*N/8, bit k*N%8. The kernels decode whole groups;
+// PackedVector::decode handles the unaligned head and tail.
+//
+// Kernels may read up to 16 bytes past the start of the last group, so
+// the source must be padded (PackedVector keeps two spare words).
+
+/// Number of values per unpack group.
+inline constexpr std::size_t unpack_group = 8;
+
+namespace detail {
+
+template <unsigned N, class T, std::size_t... K>
+inline void unpack_group_scalar(const unsigned char *p, T *out,
+                                std::index_sequence<K...>) noexcept {
+    constexpr uint64_t mask = (uint64_t(1) << N) - 1;
+    ((out[K] = static_cast<T>((load_u64(p + K * N / 8) >> (K * N % 8)) &
+                              mask)),
+     ...);
+}
+
+} // namespace detail
+
+/// Decode `groups` groups of N-bit values starting at byte p into out.
+/// T must be unsigned and hold N bits.
+template <unsigned N, class T>
+inline void unpack_groups_scalar(const unsigned char *p, std::size_t groups,
+                                 T *out) noexcept {
+    static_assert(std::is_unsigned_v<T> && N <= 8 * sizeof(T),
+                  "T must be unsigned and at least N bits wide");
+    for (std::size_t g = 0; g < groups; ++g, p += N, out += unpack_group)
+        detail::unpack_group_scalar<N>(
+            p, out, std::make_index_sequence<unpack_group>{});
+}
+
+#if SWAR_X86
+
+/// AVX2 kernel: one group per step. The group's N <= 16 bytes are
+/// broadcast to both 128-bit halves, a byte shuffle gathers each value's
+/// bytes into its own 32-bit lane, then a per-lane variable shift and a
+/// mask finish the decode. Output is 32- or 16-bit.
+template <unsigned N, class T>
+SWAR_TARGET("avx2")
+inline void unpack_groups_avx2(const unsigned char *p, std::size_t groups,
+                               T *out) noexcept {
+    static_assert(N <= 16, "a group must fit in 16 bytes");
+    static_assert(sizeof(T) == 2 || sizeof(T) == 4,
+                  "AVX2 unpack writes 16- or 32-bit values");
+    struct Tables {
+        int8_t shuffle[32];
+        int32_t shift[8];
+    };
+    static constexpr Tables tables = [] {
+        Tables t{};
+        for (unsigned k = 0; k < unpack_group; ++k) {
+            unsigned byte = k * N / 8;
+            for (unsigned j = 0; j < 4; ++j) {
+                // Indices are relative to the 128-bit half holding lane k;
+                // bytes past the group are never needed, so read zero.
+                unsigned src = byte + j;
+                t.shuffle[k * 4 + j] =
+                    src < 16 ? static_cast<int8_t>(src) : int8_t(-128);
+            }
+            t.shift[k] = static_cast<int32_t>(k * N % 8);
+        }
+        return t;
+    }();
+    const __m256i shuffle = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(tables.shuffle));
+    const __m256i shift = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(tables.shift));
+    const __m256i mask =
+        _mm256_set1_epi32(static_cast<int>((uint64_t(1) << N) - 1));
+    for (std::size_t g = 0; g < groups; ++g, p += N, out += unpack_group) {
+        __m256i bytes = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        __m256i v = _mm256_and_si256(
+            _mm256_srlv_epi32(_mm256_shuffle_epi8(bytes, shuffle), shift),
+            mask);
+        if constexpr (sizeof(T) == 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v);
+        } else {
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v),
+                                              _mm256_extracti128_si256(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+        }
+    }
+}
+
+#endif // SWAR_X86
+
+/// Decode with the widest kernel the translation unit is compiled for.
+template <unsigned N, class T>
+inline void unpack_groups(const unsigned char *p, std::size_t groups,
+                          T *out) noexcept {
+#if defined(__AVX2__)
+    if constexpr (N <= 16 && (sizeof(T) == 2 || sizeof(T) == 4))
+        return unpack_groups_avx2<N>(p, groups, out);
+#endif
+    unpack_groups_scalar<N>(p, groups, out);
+}
+
+/// A growable vector of N-bit unsigned integers packed back to back.
+///
+/// PackedWord<N> leaves 64 % N bits of every word unused; here value i
+/// simply occupies bits [i*N, (i+1)*N) of one little-endian bit stream,
+/// crossing word boundaries where it must, so storage is N bits per value
+/// (plus two spare words of padding).
+///
+/// get/set read or rewrite one unaligned 8-byte window around the value,
+/// which always holds it whole because N + 7 <= 64. decode unpacks runs of
+/// values with the kernels above: AVX2 for N <= 16 into 16/32-bit output
+/// when compiled with -mavx2, scalar with constant shifts otherwise.
+/// count_eq, find_first and filter_lt evaluate their predicate on the
+/// packed stream itself (vector_scan.hpp), several values per word op.
+///
+/// Values are in [0, max_value]; there is no guard bit.
+template <unsigned N>
+class PackedVector {
+    static_assert(N >= 1 && N <= 57, "N must be in [1,57]");
+
+  public:
+    static constexpr unsigned bits = N;
+    static constexpr uint64_t max_value = (uint64_t(1) << N) - 1;
+    /// Spare words after the last value, covering the kernels' overreads.
+    static constexpr std::size_t pad_words = 2;
+
+    PackedVector() = default;
+
+    /// A vector of n zeros.
+    explicit PackedVector(std::size_t n) { resize(n); }
+
+    /// Number of values stored.
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /// Value i. i must be < size().
+    uint64_t get(std::size_t i) const noexcept {
+        assert(i < size_);
+        std::size_t bit = i * N;
+        return (detail::load_u64(bytes() + bit / 8) >> (bit % 8)) & max_value;
+    }
+    uint64_t operator[](std::size_t i) const noexcept { return get(i); }
+
+    /// Overwrite value i with v. i must be < size().
+    void set(std::size_t i, uint64_t v) noexcept {
+        assert(i < size_ && v <= max_value);
+        std::size_t bit = i * N;
+        unsigned char *p = mutable_bytes() + bit / 8;
+        unsigned shift = bit % 8;
+        uint64_t x = detail::load_u64(p);
+        x = (x & ~(max_value << shift)) | (v << shift);
+        std::memcpy(p, &x, sizeof(x));
+    }
+
+    /// Append v.
+    void push_back(uint64_t v) {
+        assert(v <= max_value);
+        std::size_t need = words_for(size_ + 1);
+        if (words_.size() < need)
+            words_.resize(need);
+        set(size_++, v);
+    }
+
+    /// Grow (with zeros) or shrink to n values.
+    void resize(std::size_t n) {
+        if (n < size_) {
+            // Clear the dropped bits so a later grow reads zeros.
+            std::size_t bit = n * N;
+            std::size_t w = bit / 64;
+            words_[w] &= (uint64_t(1) << (bit % 64)) - 1;
+            std::fill(words_.begin() + static_cast<std::ptrdiff_t>(w + 1),
+                      words_.end(), 0);
+        }
+        words_.resize(words_for(n));
+        size_ = n;
+    }
+
+    void reserve(std::size_t n) { words_.reserve(words_for(n)); }
+    void clear() noexcept {
+        words_.clear();
+        size_ = 0;
+    }
+
+    /// out[j] = get(begin + j) for j in [0, end - begin). Whole groups of
+    /// unpack_group values go through unpack_groups; the ragged head and
+    /// tail use get. T must be unsigned and hold N bits.
+    template <class T>
+    void decode(std::size_t begin, std::size_t end, T *out) const noexcept {
+        static_assert(std::is_unsigned_v<T> && N <= 8 * sizeof(T),
+                      "T must be unsigned and at least N bits wide");
+        assert(begin <= end && end <= size_);
+        for (; begin < end && begin % unpack_group != 0; ++begin)
+            *out++ = static_cast<T>(get(begin));
+        std::size_t groups = (end - begin) / unpack_group;
+        unpack_groups<N>(bytes() + begin / unpack_group * N, groups, out);
+        begin += groups * unpack_group;
+        out += groups * unpack_group;
+        for (; begin < end; ++begin)
+            *out++ = static_cast<T>(get(begin));
+    }
+
+    // ----- predicates over the packed values -----
+
+    /// Number of values equal to v.
+    std::size_t count_eq(uint64_t v) const noexcept {
+        assert(v <= max_value);
+        return stream_count_eq<N>(bytes(), size_, v);
+    }
+
+    /// Index of the first value equal to v, or size().
+    std::size_t find_first(uint64_t v) const noexcept {
+        assert(v <= max_value);
+        return stream_find_first<N>(bytes(), size_, v);
+    }
+
+    /// Set bit i of bitmap iff get(i) < v; returns the number of bits set.
+    /// bitmap must hold bitmap_words() words (bit i is bit i % 64 of word
+    /// i / 64; bits past size() are cleared).
+    std::size_t filter_lt(uint64_t v, uint64_t *bitmap) const noexcept {
+        assert(v <= max_value);
+        return stream_filter_lt<N>(bytes(), size_, v, bitmap);
+    }
+
+    /// Words of bitmap output filter_lt writes.
+    std::size_t bitmap_words() const noexcept { return (size_ + 63) / 64; }
+
+    /// Bytes of word storage in use (including padding).
+    std::size_t memory_bytes() const noexcept {
+        return words_.size() * sizeof(uint64_t);
+    }
+
+    /// The packed bit stream, value 0 at bit 0 of byte 0.
+    const unsigned char *bytes() const noexcept {
+        return reinterpret_cast<const unsigned char *>(words_.data());
+    }
+
+    /// Direct access to underlying words (for inspection / benchmarking).
+    const std::vector<uint64_t> &words() const noexcept { return words_; }
+
+  private:
+    unsigned char *mutable_bytes() noexcept {
+        return reinterpret_cast<unsigned char *>(words_.data());
+    }
+
+    static constexpr std::size_t words_for(std::size_t n) noexcept {
+        return (n * N + 63) / 64 + pad_words;
+    }
+
+    std::vector<uint64_t> words_;
+    std::size_t size_ = 0;
+};
+
+} // namespace swar
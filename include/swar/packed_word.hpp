@@ -2,9 +2,14 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <type_traits>
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 namespace swar {
 
 /// Compute the "broadcast one" constant at compile time:
@@ -38,22 +43,77 @@ constexpr uint64_t make_high_bits() {
     return v;
 }
 
+/// Zero-lane test of PackedWord with a guard bit: the MSB of every lane is
+/// reserved (kept 0), so values are limited to [0, 2^(N-1) - 1].
+/// Setting every guard and subtracting one per lane cannot borrow across
+/// lanes, and the guard survives exactly where the lane is non-zero.
+struct GuardedZero {
+    template <unsigned N> static constexpr uint64_t max_value() noexcept {
+        return (uint64_t(1) << (N - 1)) - 1;
+    }
+
+    /// MSB of each zero lane of x.
+    template <unsigned N>
+    static constexpr uint64_t zero_lanes(uint64_t x) noexcept {
+        constexpr uint64_t high = make_high_bits<N>();
+        return ~((x | high) - make_broadcast_one<N>()) & high;
+    }
+
+    /// MSB of each lane where a < b.
+    template <unsigned N>
+    static constexpr uint64_t less_than(uint64_t a, uint64_t b) noexcept {
+        constexpr uint64_t high = make_high_bits<N>();
+        return ~((a | high) - b) & high;
+    }
+};
+
+/// Zero-lane test of PackedWord without a guard bit: lanes use all N bits,
+/// values are in [0, 2^N - 1]. The low N-1 bits (L) are tested by adding
+/// L, which carries into the MSB iff any of them is set and never past
+/// it; the MSB is tested directly. Ordered compares split the same way.
+/// One or two more operations than GuardedZero.
+struct ExactZero {
+    template <unsigned N> static constexpr uint64_t max_value() noexcept {
+        return (uint64_t(1) << N) - 1;
+    }
+
+    template <unsigned N>
+    static constexpr uint64_t zero_lanes(uint64_t x) noexcept {
+        constexpr uint64_t high = make_high_bits<N>();
+        constexpr uint64_t low = make_lane_mask_broadcast<N>() & ~high;
+        return ~(((x & low) + low) | x) & high;
+    }
+
+    /// a < b where the MSBs differ, else where the low bits of a are
+    /// below those of b: (a | H) - (b & L) keeps a lane's MSB iff
+    /// a_low >= b_low.
+    template <unsigned N>
+    static constexpr uint64_t less_than(uint64_t a, uint64_t b) noexcept {
+        constexpr uint64_t high = make_high_bits<N>();
+        constexpr uint64_t low = make_lane_mask_broadcast<N>() & ~high;
+        uint64_t d = (a | high) - (b & low);
+        return ((~a & b) | ~((a ^ b) | d)) & high;
+    }
+};
+
 /// A single machine word packing floor(64/N) values of N bits each.
 ///
 /// N must be in [5, 14] for the intended use case, but the implementation
 /// works for any N in [1, 32].
 ///
-/// IMPORTANT: The haszero trick requires that the MSB of each lane is NOT
-/// part of the value space. For contains/find/count_eq to work correctly
-/// without false positives, values must be in [0, 2^(N-1) - 1] — i.e. the
-/// top bit of each lane is reserved as a "guard bit". This means:
-///   - For N=5, valid values are 0..15  (4 usable bits)
-///   - For N=6, valid values are 0..31  (5 usable bits)
-///   - etc.
+/// The search and compare operations (contains/find/count_eq and the
+/// ordered masks) go through the ZeroTest policy:
+///   - GuardedZero (default) reserves the MSB of each lane as a guard
+///     bit, so values must be in [0, 2^(N-1) - 1]:
+///       - For N=5, valid values are 0..15  (4 usable bits)
+///       - For N=6, valid values are 0..31  (5 usable bits)
+///       - etc.
+///   - ExactZero lifts the restriction, so the full range [0, 2^N - 1]
+///     works, at the cost of one or two more operations per test.
+/// max_safe_value is the largest value the chosen policy supports.
 ///
-/// If you don't need contains/find/count_eq, the full range [0, 2^N - 1]
-/// can be used for get/set/broadcast.
-template <unsigned N>
+/// get/set/broadcast and min/max always accept the full range [0, 2^N - 1].
+template <unsigned N, class ZeroTest = GuardedZero>
 class PackedWord {
     static_assert(N >= 1 && N <= 32, "N must be in [1,32]");
 
@@ -66,8 +126,12 @@ class PackedWord {
     static constexpr uint64_t all_lanes_mask = make_lane_mask_broadcast<N>();
     static constexpr uint64_t high_bits = make_high_bits<N>();
 
-    // Maximum value that can safely be used with contains/find (guard-bit safe)
-    static constexpr uint64_t max_safe_value = (uint64_t(1) << (N - 1)) - 1;
+    using zero_test = ZeroTest;
+
+    // Maximum value that can safely be used with contains/find (guard-bit
+    // safe unless ZeroTest is ExactZero)
+    static constexpr uint64_t max_safe_value =
+        ZeroTest::template max_value<N>();
 
     // ----- construction -----
     constexpr PackedWord() noexcept : word_(0) {}
@@ -101,12 +165,14 @@ class PackedWord {
     }
 
     // ----- SWAR search operations -----
-    // These require values to have their MSB clear (guard bit = 0).
+    // With GuardedZero these require values to have their MSB clear
+    // (guard bit = 0); with ExactZero any lane value works.
 
-    /// Returns a mask word with the MSB of each lane set if that lane is zero.
-    /// Implements: haszero(x) = (x - ones) & ~x & high_bits
+    /// Returns a mask word with the MSB of each lane set if that lane is
+    /// zero (ZeroTest::zero_lanes). Exact in every lane, so the mask can be
+    /// counted, not only tested.
     constexpr uint64_t zero_lanes_mask() const noexcept {
-        return (word_ - broadcast_one) & ~word_ & high_bits;
+        return ZeroTest::template zero_lanes<N>(word_);
     }
 
     /// True if any lane equals v.
@@ -143,22 +209,216 @@ class PackedWord {
     constexpr unsigned count_eq(uint64_t v) const noexcept {
         assert(v <= max_safe_value);
         uint64_t mask = PackedWord(word_ ^ broadcast(v).raw()).zero_lanes_mask();
+        return count_lanes(mask);
+    }
+
+    /// Number of lanes flagged in a mask with at most the MSB of each lane
+    /// set (as returned by zero_lanes_mask and the comparison masks).
+    /// Without a hardware popcount, the flags are summed into the top lane
+    /// with one multiply, which is exact while lanes < 2^N (N >= 5).
+    static constexpr unsigned count_lanes(uint64_t mask) noexcept {
+#if !defined(__POPCNT__)
+        if constexpr (lanes < (uint64_t(1) << N)) {
+            uint64_t sum = (mask >> (N - 1)) * broadcast_one;
+            return static_cast<unsigned>((sum >> ((lanes - 1) * N)) & lane_mask);
+        }
+#endif
         return static_cast<unsigned>(__builtin_popcountll(mask));
     }
 
-    // ----- min / max (iterative — simple and correct) -----
+    // ----- ordered comparisons -----
+    // Same value range as above. With GuardedZero, setting the guard bit
+    // of every lane of a and subtracting b gives 2^(N-1) + a - b per lane,
+    // which never borrows into the next lane; its guard bit survives
+    // exactly where a >= b. ExactZero compares the MSBs separately.
+    // Results are masks with the MSB of each matching lane set, like
+    // zero_lanes_mask.
+
+    /// MSB of each lane set where this lane < v.
+    constexpr uint64_t less_than_mask(uint64_t v) const noexcept {
+        assert(v <= max_safe_value);
+        return less_than_mask(broadcast(v));
+    }
+
+    /// MSB of each lane set where this lane > v.
+    constexpr uint64_t greater_than_mask(uint64_t v) const noexcept {
+        assert(v <= max_safe_value);
+        return greater_than_mask(broadcast(v));
+    }
+
+    /// MSB of each lane set where this lane <= v.
+    constexpr uint64_t less_equal_mask(uint64_t v) const noexcept {
+        return ~greater_than_mask(v) & high_bits;
+    }
+
+    /// MSB of each lane set where this lane >= v.
+    constexpr uint64_t greater_equal_mask(uint64_t v) const noexcept {
+        return ~less_than_mask(v) & high_bits;
+    }
+
+    /// MSB of each lane set where lo <= this lane <= hi.
+    constexpr uint64_t in_range_mask(uint64_t lo, uint64_t hi) const noexcept {
+        return greater_equal_mask(lo) & less_equal_mask(hi);
+    }
+
+    /// MSB of each lane set where this lane < the same lane of o.
+    constexpr uint64_t less_than_mask(const PackedWord &o) const noexcept {
+        return ZeroTest::template less_than<N>(word_, o.word_);
+    }
+
+    /// MSB of each lane set where this lane > the same lane of o.
+    constexpr uint64_t greater_than_mask(const PackedWord &o) const noexcept {
+        return o.less_than_mask(*this);
+    }
+
+    /// MSB of each lane set where this lane <= the same lane of o.
+    constexpr uint64_t less_equal_mask(const PackedWord &o) const noexcept {
+        return ~greater_than_mask(o) & high_bits;
+    }
+
+    /// MSB of each lane set where this lane >= the same lane of o.
+    constexpr uint64_t greater_equal_mask(const PackedWord &o) const noexcept {
+        return ~less_than_mask(o) & high_bits;
+    }
+
+    // ----- word vs word -----
+
+    /// Rotate lanes down by r: lane i of the result is lane (i + r) % lanes.
+    constexpr PackedWord rotate_lanes(unsigned r) const noexcept {
+        assert(r < lanes);
+        if (r == 0)
+            return *this;
+        uint64_t x = word_ & all_lanes_mask;
+        return PackedWord(((x >> (r * N)) | (x << ((lanes - r) * N))) &
+                          all_lanes_mask);
+    }
+
+    /// MSB of each non-zero lane of this whose value equals some lane of o.
+    /// Compares against every rotation of o, so it costs `lanes` zero
+    /// tests and never extracts a lane.
+    constexpr uint64_t match_any_mask(const PackedWord &o) const noexcept {
+        uint64_t m = 0;
+        for (unsigned r = 0; r < lanes; ++r)
+            m |= PackedWord(word_ ^ o.rotate_lanes(r).raw()).zero_lanes_mask();
+        return m & ~zero_lanes_mask();
+    }
+
+    // ----- lane compaction -----
+    // Masks select lanes by their MSB, like zero_lanes_mask and the
+    // comparison masks. Compiled with BMI2 (-mbmi2), compress and expand
+    // are one PEXT / PDEP over the selected lanes' bits and unpack_all
+    // spreads 64 / (8 * sizeof(T)) lanes per PDEP. Otherwise they are the
+    // *_scalar variants, which move one selected lane per iteration.
+
+    /// Widen a mask of lane MSBs to every bit of those lanes.
+    static constexpr uint64_t lanes_of(uint64_t high) noexcept {
+        return high | (high - (high >> (N - 1)));
+    }
+
+    /// The lanes flagged in mask, in order, gathered into the low lanes;
+    /// the remaining lanes are zero.
+    PackedWord compress(uint64_t mask) const noexcept {
+#if defined(__BMI2__)
+        return PackedWord(_pext_u64(word_, lanes_of(mask & high_bits)));
+#else
+        return compress_scalar(mask);
+#endif
+    }
+
+    /// Inverse of compress: the low lanes, in order, moved to the lanes
+    /// flagged in mask; the remaining lanes are zero.
+    PackedWord expand(uint64_t mask) const noexcept {
+#if defined(__BMI2__)
+        return PackedWord(_pdep_u64(word_, lanes_of(mask & high_bits)));
+#else
+        return expand_scalar(mask);
+#endif
+    }
+
+    /// out[i] = get(i) for every lane. T must be unsigned and hold N bits.
+    template <class T> void unpack_all(T *out) const noexcept {
+        static_assert(std::is_unsigned_v<T> && N <= 8 * sizeof(T),
+                      "T must be unsigned and at least N bits wide");
+#if defined(__BMI2__)
+        constexpr unsigned width = 8 * sizeof(T);
+        if constexpr (width < 64) {
+            constexpr unsigned per_step = 64 / width;
+            constexpr unsigned steps = (lanes + per_step - 1) / per_step;
+            constexpr uint64_t spread = [] {
+                uint64_t m = 0;
+                for (unsigned j = 0; j < per_step; ++j)
+                    m |= lane_mask << (j * width);
+                return m;
+            }();
+            T buf[steps * per_step];
+            for (unsigned k = 0; k < steps; ++k) {
+                uint64_t v = _pdep_u64(word_ >> (k * per_step * N), spread);
+                std::memcpy(buf + k * per_step, &v, sizeof(v));
+            }
+            std::memcpy(out, buf, lanes * sizeof(T));
+            return;
+        }
+#endif
+        unpack_all_scalar(out);
+    }
+
+    /// compress, one lane at a time.
+    constexpr PackedWord compress_scalar(uint64_t mask) const noexcept {
+        uint64_t out = 0;
+        unsigned shift = 0;
+        for (mask &= high_bits; mask != 0; mask &= mask - 1, shift += N) {
+            unsigned at =
+                static_cast<unsigned>(__builtin_ctzll(mask)) - (N - 1);
+            out |= ((word_ >> at) & lane_mask) << shift;
+        }
+        return PackedWord(out);
+    }
+
+    /// expand, one lane at a time.
+    constexpr PackedWord expand_scalar(uint64_t mask) const noexcept {
+        uint64_t out = 0;
+        uint64_t x = word_;
+        for (mask &= high_bits; mask != 0; mask &= mask - 1, x >>= N) {
+            unsigned at =
+                static_cast<unsigned>(__builtin_ctzll(mask)) - (N - 1);
+            out |= (x & lane_mask) << at;
+        }
+        return PackedWord(out);
+    }
+
+    /// unpack_all with one get per lane.
+    template <class T> void unpack_all_scalar(T *out) const noexcept {
+        for (unsigned i = 0; i < lanes; ++i)
+            out[i] = static_cast<T>(get(i));
+    }
+
+    // ----- min / max -----
+    // Lanes hold full N-bit values here (no guard bit needed).
+    //
+    // With at least swar_min_max_lanes lanes (N <= 10) the reduction is
+    // lane-parallel: the first step splits even and odd lanes into 2N-bit
+    // fields, so each field has N spare bits and a lane-wise compare is one
+    // guarded subtraction; the remaining log2(lanes / 2) steps fold the
+    // upper fields onto the lower ones. Lanes at or above `count` are
+    // zeroed, the identity for max; min is the complement of the max of
+    // the complements. With fewer lanes the extract-and-compare loop has
+    // the shorter dependency chain and is kept.
+
+    /// Lane count from which min/max use the SWAR reduction.
+    static constexpr unsigned swar_min_max_lanes = 6;
 
     /// Minimum value across all occupied lanes.
     /// `count` is the number of valid lanes (from LSB). Defaults to all lanes.
     constexpr uint64_t min(unsigned count) const noexcept {
         assert(count > 0 && count <= lanes);
-        uint64_t m = get(0);
-        for (unsigned i = 1; i < count; ++i) {
-            uint64_t v = get(i);
-            if (v < m)
-                m = v;
+        if constexpr (lanes >= swar_min_max_lanes) {
+            return lane_mask ^ max_lanes(~word_ & lanes_below(count));
+        } else {
+            uint64_t m = get(0);
+            for (unsigned i = 1; i < count; ++i)
+                m = get(i) < m ? get(i) : m;
+            return m;
         }
-        return m;
     }
 
     constexpr uint64_t min() const noexcept { return min(lanes); }
@@ -166,13 +426,14 @@ class PackedWord {
     /// Maximum value across all occupied lanes.
     constexpr uint64_t max(unsigned count) const noexcept {
         assert(count > 0 && count <= lanes);
-        uint64_t m = get(0);
-        for (unsigned i = 1; i < count; ++i) {
-            uint64_t v = get(i);
-            if (v > m)
-                m = v;
+        if constexpr (lanes >= swar_min_max_lanes) {
+            return max_lanes(word_ & lanes_below(count));
+        } else {
+            uint64_t m = get(0);
+            for (unsigned i = 1; i < count; ++i)
+                m = get(i) > m ? get(i) : m;
+            return m;
         }
-        return m;
     }
 
     constexpr uint64_t max() const noexcept { return max(lanes); }
@@ -186,6 +447,53 @@ class PackedWord {
     }
 
   private:
+    /// All bits of lanes [0, count).
+    static constexpr uint64_t lanes_below(unsigned count) noexcept {
+        return count >= lanes
+                   ? all_lanes_mask
+                   : all_lanes_mask & ((uint64_t(1) << (count * N)) - 1);
+    }
+
+    /// Lane mask at every even lane: the low half of each 2N-bit field.
+    static constexpr uint64_t even_lanes = [] {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < lanes; i += 2)
+            v |= lane_mask << (i * N);
+        return v;
+    }();
+    /// Bit N of every 2N-bit field: the borrow guard for field compares.
+    static constexpr uint64_t field_guards = [] {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < lanes; i += 2)
+            v |= uint64_t(1) << (i * N + N);
+        return v;
+    }();
+
+    /// Per 2N-bit field, the larger of a and b. Fields hold values below
+    /// 2^N, so (a | guard) - b never borrows across fields and the guard
+    /// survives exactly where a >= b.
+    static constexpr uint64_t max_fields(uint64_t a, uint64_t b) noexcept {
+        uint64_t ge = ((a | field_guards) - b) & field_guards;
+        uint64_t take_a = ge - (ge >> N);
+        return b ^ ((a ^ b) & take_a);
+    }
+
+    /// Fold the fields `Span` lanes apart onto each other until field 0
+    /// holds the maximum (unrolled at compile time).
+    template <unsigned Span>
+    static constexpr uint64_t fold_fields(uint64_t x) noexcept {
+        if constexpr (Span >= lanes)
+            return x;
+        else
+            return fold_fields<Span * 2>(max_fields(x, x >> (Span * N)));
+    }
+
+    /// Maximum of the lanes of x; bits outside all_lanes_mask must be 0.
+    static constexpr uint64_t max_lanes(uint64_t x) noexcept {
+        x = max_fields(x & even_lanes, (x >> N) & even_lanes);
+        return fold_fields<2>(x) & lane_mask;
+    }
+
     uint64_t word_;
 };
 
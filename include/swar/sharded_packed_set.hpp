@@ -0,0 +1,182 @@
+#pragma once
+
+#include "packed_set.hpp"
+#include "packed_set_arena.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace swar {
+
+/// Lane width a ShardedPackedSet shard needs: the key's low bits, stored
+/// plus one (so key 0 is not the empty lane), plus the guard bit.
+constexpr unsigned shard_lane_bits(unsigned shard_bits) {
+    return 16 - shard_bits + 2;
+}
+
+/// Default shard capacity: as many lanes as fit in one cache line, but no
+/// more than the shard's share of the key space.
+constexpr std::size_t default_shard_capacity(unsigned shard_bits) {
+    std::size_t line_lanes = 64 / shard_lane_bits(shard_bits) * 8;
+    std::size_t keys = std::size_t(1) << (16 - shard_bits);
+    return line_lanes < keys ? line_lanes : keys;
+}
+
+/// A set of 16-bit keys split into 2^ShardBits shards by the key's top
+/// ShardBits bits, each shard a PackedSet of the remaining low bits in
+/// its own cache line: BucketedSet's MSB partitioning taken to many
+/// partitions.
+///
+/// With the default ShardBits = 10, a shard stores 6-bit keys in 8-bit
+/// lanes, 8 words of 8 lanes = 64 keys = its whole key range, so the set
+/// holds any subset of [0, 65535] and every lookup scans one line. Other
+/// ShardBits may leave shards smaller than their key range; an insert
+/// into a full shard returns false, as PackedSet::insert does.
+///
+/// Shards are independent, which gives a lock-free ingest path without
+/// atomics: writer(t, writers) hands thread t a contiguous run of shards,
+/// and only that thread may update them. Writers never share a line, so
+/// they neither contend nor false-share. Each writer ingests the whole
+/// key stream, keeping the keys routed to its shards.
+///
+/// Reads (contains, for_each, count) see the shards as one merged set.
+/// They are not synchronised with writers: read once the writers are
+/// joined (or otherwise ordered before the reads).
+template <unsigned ShardBits = 10,
+          std::size_t ShardCapacity = default_shard_capacity(ShardBits)>
+class ShardedPackedSet {
+    static_assert(ShardBits >= 1 && ShardBits <= 14,
+                  "ShardBits must be in [1,14]");
+
+  public:
+    using key_type = uint16_t;
+
+    static constexpr unsigned shard_bits = ShardBits;
+    static constexpr unsigned low_bits = 16 - ShardBits;
+    static constexpr std::size_t shard_count = std::size_t(1) << ShardBits;
+    static constexpr std::size_t shard_capacity = ShardCapacity;
+    using Shard = PackedSet<shard_lane_bits(ShardBits), ShardCapacity>;
+
+    ShardedPackedSet() : shards_(shard_count) {}
+
+    /// Shard holding key.
+    static constexpr std::size_t shard_of(key_type key) noexcept {
+        return key >> low_bits;
+    }
+
+    // ----- single-threaded updates -----
+
+    /// Insert key. Returns true if inserted, false if already present or
+    /// its shard is full.
+    bool insert(key_type key) { return shard(key).insert(stored_of(key)); }
+
+    /// Remove key. Returns true if it was present.
+    bool erase(key_type key) { return shard(key).erase(stored_of(key)); }
+
+    // ----- merged read view -----
+
+    bool contains(key_type key) const {
+        return shards_[shard_of(key)].set.contains(stored_of(key));
+    }
+
+    /// Call f(key) for every key, shard by shard in ascending shard
+    /// order; order within a shard is the shard's storage order.
+    template <class F> void for_each(F f) const {
+        for (std::size_t s = 0; s < shard_count; ++s) {
+            const key_type high = static_cast<key_type>(s << low_bits);
+            shards_[s].set.for_each([&](uint64_t v) {
+                f(static_cast<key_type>(high | (v - 1)));
+            });
+        }
+    }
+
+    /// Number of keys stored.
+    std::size_t count() const {
+        std::size_t n = 0;
+        for_each([&](key_type) { ++n; });
+        return n;
+    }
+
+    /// Shard s (for inspection / benchmarking).
+    const Shard &shard_at(std::size_t s) const noexcept {
+        assert(s < shard_count);
+        return shards_[s].set;
+    }
+
+    // ----- thread-affine ingest -----
+
+    /// Exclusive update access to shards [begin(), end()). Writers from
+    /// writer(t, writers) for distinct t own disjoint shard runs and may
+    /// be used concurrently, one thread each.
+    class Writer {
+      public:
+        std::size_t begin() const noexcept { return begin_; }
+        std::size_t end() const noexcept { return end_; }
+
+        bool owns(key_type key) const noexcept {
+            std::size_t s = shard_of(key);
+            return s >= begin_ && s < end_;
+        }
+
+        /// Insert an owned key; same result as ShardedPackedSet::insert.
+        bool insert(key_type key) {
+            assert(owns(key));
+            return set_->insert(key);
+        }
+
+        /// Insert the keys of [keys, keys + n) this writer owns, skipping
+        /// the rest. Returns the number inserted.
+        std::size_t ingest(const key_type *keys, std::size_t n) {
+            std::size_t added = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (owns(keys[i]))
+                    added += set_->insert(keys[i]);
+            }
+            return added;
+        }
+
+        /// Empty every owned shard.
+        void clear() noexcept {
+            for (std::size_t s = begin_; s < end_; ++s)
+                set_->shards_[s].set = Shard();
+        }
+
+      private:
+        friend class ShardedPackedSet;
+
+        Writer(ShardedPackedSet *set, std::size_t begin,
+               std::size_t end) noexcept
+            : set_(set), begin_(begin), end_(end) {}
+
+        ShardedPackedSet *set_;
+        std::size_t begin_, end_;
+    };
+
+    /// Writer t of `writers`, owning shards [t * S / writers,
+    /// (t + 1) * S / writers) for S = shard_count. With more writers
+    /// than shards some writers own nothing.
+    Writer writer(std::size_t t, std::size_t writers) noexcept {
+        assert(writers >= 1 && t < writers);
+        return Writer(this, t * shard_count / writers,
+                      (t + 1) * shard_count / writers);
+    }
+
+  private:
+    /// One shard per cache line.
+    struct alignas(CacheLineAllocator<char>::alignment) Slot {
+        Shard set;
+    };
+
+    static constexpr uint64_t low_mask = (uint64_t(1) << low_bits) - 1;
+
+    static constexpr uint64_t stored_of(key_type key) noexcept {
+        return (key & low_mask) + 1;
+    }
+
+    Shard &shard(key_type key) noexcept { return shards_[shard_of(key)].set; }
+
+    std::vector<Slot, CacheLineAllocator<Slot>> shards_;
+};
+
+} // namespace swar
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "dispatch.hpp"
+#include "packed_word.hpp"
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace swar {
+
+/// A fixed-capacity set of N-bit integers kept in ascending order across
+/// an array of PackedWord<N>.
+///
+/// Element i lives in slot i: word i / lanes_per_word, lane
+/// i % lanes_per_word. Slots [0, size()) are occupied and sorted; the rest
+/// hold zero. Because the order is global, the last occupied lane of each
+/// word is a fence key: lookups binary-search the fences to pick one word,
+/// then rank inside it with less_than_mask and a lane count, so no lane is
+/// extracted. Sets of at most linear_words words skip the search: rank is
+/// one less_than_mask count over every word and contains is the PackedSet
+/// scan. insert/erase shift the tail of the set by one lane with
+/// word-level shifts, carrying the boundary lane between words.
+///
+/// Stored values must be in [1, max_safe_value].
+template <unsigned N, std::size_t Capacity>
+class SortedPackedSet {
+    static_assert(Capacity > 0, "Capacity must be > 0");
+
+  public:
+    using Word = PackedWord<N>;
+    static constexpr unsigned lanes_per_word = Word::lanes;
+    static constexpr std::size_t num_words =
+        (Capacity + lanes_per_word - 1) / lanes_per_word;
+    static constexpr std::size_t capacity = Capacity;
+
+    /// Sets of at most this many words rank and look up with a linear
+    /// SWAR pass over every word instead of a fence binary search.
+    static constexpr std::size_t linear_words = 8;
+
+    constexpr SortedPackedSet() noexcept : words_{}, size_(0) {}
+
+    /// Insert a value. Returns true if inserted, false if already present
+    /// or the set holds Capacity elements.
+    bool insert(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        std::size_t pos = lower_bound(v);
+        if (pos < size_ && at(pos) == v)
+            return false;
+        if (size_ == capacity)
+            return false;
+        std::size_t wi = pos / lanes_per_word;
+        unsigned k = static_cast<unsigned>(pos % lanes_per_word);
+        std::size_t last = size_ / lanes_per_word; // word of the new slot
+        // Lane carried out of the top of the current word into the next.
+        uint64_t carry = words_[wi].get(lanes_per_word - 1);
+        uint64_t w = words_[wi].raw();
+        uint64_t keep = w & low_lanes(k);
+        uint64_t moved = (w & ~low_lanes(k)) << N;
+        words_[wi] = Word(keep | (moved & Word::all_lanes_mask) |
+                          (v << (k * N)));
+        for (std::size_t i = wi + 1; i <= last; ++i) {
+            uint64_t cur = words_[i].raw();
+            uint64_t out = words_[i].get(lanes_per_word - 1);
+            words_[i] = Word(((cur << N) & Word::all_lanes_mask) | carry);
+            carry = out;
+        }
+        ++size_;
+        return true;
+    }
+
+    /// Remove a value. Returns true if it was present.
+    bool erase(uint64_t v) {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        std::size_t pos = lower_bound(v);
+        if (pos == size_ || at(pos) != v)
+            return false;
+        std::size_t wi = pos / lanes_per_word;
+        unsigned k = static_cast<unsigned>(pos % lanes_per_word);
+        std::size_t last = (size_ - 1) / lanes_per_word;
+        constexpr unsigned top = (lanes_per_word - 1) * N;
+        uint64_t w = words_[wi].raw();
+        uint64_t keep = w & low_lanes(k);
+        uint64_t moved = (w >> N) & ~low_lanes(k);
+        for (std::size_t i = wi; i < last; ++i) {
+            uint64_t next = words_[i + 1].raw();
+            words_[i] = Word(keep | moved | ((next & Word::lane_mask) << top));
+            keep = 0;
+            moved = next >> N;
+        }
+        words_[last] = Word(keep | moved);
+        --size_;
+        return true;
+    }
+
+    /// Check if the set contains value v.
+    bool contains(uint64_t v) const {
+        assert(v >= 1 && v <= Word::max_safe_value);
+        if constexpr (num_words <= linear_words) {
+            return scan_words<N, num_words>(words_.data(), v) != num_words;
+        } else {
+            std::size_t wi = fence_search(v);
+            return wi < used_words() && words_[wi].contains(v);
+        }
+    }
+
+    // ----- ordered queries -----
+
+    /// Number of elements < v; also the slot of the first element >= v.
+    std::size_t lower_bound(uint64_t v) const {
+        assert(v <= Word::max_safe_value);
+        if (v == 0)
+            return 0;
+        if constexpr (num_words <= linear_words) {
+            // Empty lanes hold 0 < v; every one of them is counted.
+            std::size_t below = 0;
+            for (const auto &w : words_)
+                below += Word::count_lanes(w.less_than_mask(v));
+            return below - (num_words * lanes_per_word - size_);
+        } else {
+            std::size_t wi = fence_search(v);
+            if (wi == used_words())
+                return size_;
+            return wi * lanes_per_word +
+                   Word::count_lanes(words_[wi].less_than_mask(v) &
+                                     occupied_high(wi));
+        }
+    }
+
+    /// Number of elements <= v; also the slot of the first element > v.
+    std::size_t upper_bound(uint64_t v) const {
+        assert(v <= Word::max_safe_value);
+        return v == Word::max_safe_value ? size_ : lower_bound(v + 1);
+    }
+
+    /// Number of elements < v.
+    std::size_t rank(uint64_t v) const { return lower_bound(v); }
+
+    /// Slots [first, last) of the elements in [lo, hi].
+    std::pair<std::size_t, std::size_t> range(uint64_t lo,
+                                              uint64_t hi) const {
+        std::size_t first = lower_bound(lo);
+        std::size_t last = hi < lo ? first : upper_bound(hi);
+        return {first, last};
+    }
+
+    /// Number of elements in [lo, hi].
+    std::size_t count_in_range(uint64_t lo, uint64_t hi) const {
+        auto r = range(lo, hi);
+        return r.second - r.first;
+    }
+
+    /// Element in slot i (the i-th smallest). i must be < size().
+    uint64_t at(std::size_t i) const noexcept {
+        assert(i < size_);
+        return words_[i / lanes_per_word].get(
+            static_cast<unsigned>(i % lanes_per_word));
+    }
+
+    /// Smallest / largest element. The set must not be empty.
+    uint64_t min() const noexcept { return at(0); }
+    uint64_t max() const noexcept { return at(size_ - 1); }
+
+    /// Number of elements currently stored.
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /// Number of PackedWords backing this set.
+    static constexpr std::size_t word_count() noexcept { return num_words; }
+
+    /// Direct access to underlying words (for inspection / benchmarking).
+    const std::array<Word, num_words> &words() const noexcept {
+        return words_;
+    }
+
+  private:
+    /// All bits of lanes [0, k), k <= lanes_per_word.
+    static constexpr uint64_t low_lanes(unsigned k) noexcept {
+        return k >= lanes_per_word
+                   ? Word::all_lanes_mask
+                   : Word::all_lanes_mask & ((uint64_t(1) << (k * N)) - 1);
+    }
+
+    /// Words holding at least one element.
+    std::size_t used_words() const noexcept {
+        return (size_ + lanes_per_word - 1) / lanes_per_word;
+    }
+
+    /// Number of occupied lanes in word wi (wi < used_words()).
+    unsigned occupied(std::size_t wi) const noexcept {
+        std::size_t rest = size_ - wi * lanes_per_word;
+        return rest < lanes_per_word ? static_cast<unsigned>(rest)
+                                     : lanes_per_word;
+    }
+
+    /// Guard bits of the occupied lanes of word wi.
+    uint64_t occupied_high(std::size_t wi) const noexcept {
+        return Word::high_bits & low_lanes(occupied(wi));
+    }
+
+    /// First word whose largest element (fence) is >= v, or used_words().
+    /// Full words are searched by their top lane; only the last, partly
+    /// filled word needs its occupied lane count.
+    std::size_t fence_search(uint64_t v) const noexcept {
+        constexpr unsigned top = (lanes_per_word - 1) * N;
+        std::size_t full = size_ / lanes_per_word;
+        std::size_t lo = 0, hi = full;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (((words_[mid].raw() >> top) & Word::lane_mask) < v)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < full || full == used_words())
+            return lo;
+        return words_[full].get(occupied(full) - 1) < v ? full + 1 : full;
+    }
+
+    std::array<Word, num_words> words_;
+    std::size_t size_;
+};
+
+} // namespace swar
@@ -0,0 +1,427 @@
+#pragma once
+
+#include "packed_word.hpp"
+#include "word_scan.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace swar {
+
+namespace detail {
+
+inline uint64_t load_u64(const unsigned char *p) noexcept {
+    uint64_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+} // namespace detail
+
+/// Predicate kernels over a bit stream of back-to-back N-bit values (the
+/// PackedVector layout), evaluated without decoding.
+///
+/// The stream is read in windows: one unaligned 8-byte load shifted right
+/// by the window's bit offset within its first byte, so a window holds
+/// lanes = 57 / N whole values at the PackedWord<N> lane positions. Eight
+/// windows span exactly lanes * N bytes, so inside a block of eight the
+/// byte offset and shift of every window are compile-time constants.
+///
+/// Stream values use all N bits, so there is no guard bit to borrow into.
+/// The masks use the exact forms instead, again with the MSB of each
+/// flagged lane set (L = the low N-1 bits of every lane, H = the MSBs):
+///   x == b:  y = x ^ b;  ~(((y & L) + L) | y) & H
+///   x <  b:  d = (x | H) - (b & L) keeps a lane's MSB iff x_low >= b_low;
+///            ((~x & b) | (~(x ^ b) & ~d)) & H
+/// Neither sum nor difference leaves its lane.
+///
+/// Kernels read up to 8 bytes past the last value (PackedVector keeps two
+/// spare words). The AVX2 kernels gather four windows per step and fall
+/// back to the scalar ones for the remainder.
+template <unsigned N> struct StreamWindow {
+    static_assert(N >= 1 && N <= 57, "N must be in [1,57]");
+
+    static constexpr unsigned lanes = 57 / N;
+    static constexpr unsigned stride_bits = lanes * N;
+    /// Windows per block; a block is stride_bits bytes long.
+    static constexpr unsigned block = 8;
+    static constexpr uint64_t all = (uint64_t(1) << stride_bits) - 1;
+    static constexpr uint64_t lane_mask = (uint64_t(1) << N) - 1;
+    static constexpr uint64_t ones = make_broadcast_one<N>() & all;
+    static constexpr uint64_t high = make_high_bits<N>() & all;
+    static constexpr uint64_t low = all & ~high;
+
+    /// Window w of the stream at p (any w).
+    static uint64_t at(const unsigned char *p, std::size_t w) noexcept {
+        std::size_t bit = w * stride_bits;
+        return (detail::load_u64(p + bit / 8) >> (bit % 8)) & all;
+    }
+
+    /// Window k of the block starting at byte p.
+    template <unsigned K>
+    static uint64_t in_block(const unsigned char *p) noexcept {
+        return (detail::load_u64(p + K * stride_bits / 8) >> (K * stride_bits % 8)) & all;
+    }
+
+    static constexpr uint64_t broadcast(uint64_t v) noexcept {
+        return v * ones;
+    }
+
+    static constexpr uint64_t eq_mask(uint64_t x, uint64_t b) noexcept {
+        uint64_t y = x ^ b;
+        return ~(((y & low) + low) | y) & high;
+    }
+
+    static constexpr uint64_t lt_mask(uint64_t x, uint64_t b) noexcept {
+        uint64_t d = (x | high) - (b & low);
+        return ((~x & b) | (~(x ^ b) & ~d)) & high;
+    }
+
+    /// MSBs of the first k lanes (k <= lanes).
+    static constexpr uint64_t first_lanes(unsigned k) noexcept {
+        return k >= lanes ? high : high & ((uint64_t(1) << (k * N)) - 1);
+    }
+
+    /// Number of lanes flagged in mask, as PackedWord::count_lanes.
+    static constexpr unsigned count(uint64_t mask) noexcept {
+#if !defined(__POPCNT__)
+        if constexpr (lanes < (uint64_t(1) << N)) {
+            uint64_t sum = (mask >> (N - 1)) * ones;
+            return static_cast<unsigned>((sum >> ((lanes - 1) * N)) &
+                                         lane_mask);
+        }
+#endif
+        return static_cast<unsigned>(__builtin_popcountll(mask));
+    }
+
+    /// Gather the lane MSBs of mask into bits [0, lanes).
+    static uint64_t compress(uint64_t mask) noexcept {
+#if defined(__BMI2__)
+        return _pext_u64(mask, high);
+#else
+        if constexpr (N == 1) {
+            return mask;
+        } else {
+            uint64_t out = 0;
+            for (; mask != 0; mask &= mask - 1)
+                out |= uint64_t(1) << (__builtin_ctzll(mask) / N);
+            return out;
+        }
+#endif
+    }
+};
+
+namespace detail {
+
+/// Appends bit runs of up to 57 bits to a bitmap, one word at a time.
+class BitmapWriter {
+  public:
+    explicit BitmapWriter(uint64_t *out) noexcept : out_(out) {}
+
+    void put(uint64_t bits, unsigned count) noexcept {
+        acc_ |= bits << fill_;
+        fill_ += count;
+        if (fill_ >= 64) {
+            *out_++ = acc_;
+            fill_ -= 64;
+            acc_ = fill_ ? bits >> (count - fill_) : 0;
+        }
+    }
+
+    void finish() noexcept {
+        if (fill_)
+            *out_ = acc_;
+    }
+
+  private:
+    uint64_t *out_;
+    uint64_t acc_ = 0;
+    unsigned fill_ = 0;
+};
+
+/// f(window) for each window of the block at p, fully unrolled.
+template <unsigned N, class F, unsigned... K>
+inline void for_block(const unsigned char *p, F f,
+                      std::integer_sequence<unsigned, K...>) noexcept {
+    using SW = StreamWindow<N>;
+    (f(SW::template in_block<K>(p)), ...);
+}
+
+} // namespace detail
+
+// ----- scalar -----
+
+/// Number of values equal to v among the first n of the stream at p.
+template <unsigned N>
+inline std::size_t stream_count_eq_scalar(const unsigned char *p,
+                                          std::size_t n, uint64_t v) noexcept {
+    using SW = StreamWindow<N>;
+    const uint64_t b = SW::broadcast(v);
+    const std::size_t full = n / SW::lanes;
+    std::size_t count = 0, w = 0;
+    for (; w + SW::block <= full; w += SW::block, p += SW::stride_bits) {
+        detail::for_block<N>(
+            p,
+            [&](uint64_t x) { count += SW::count(SW::eq_mask(x, b)); },
+            std::make_integer_sequence<unsigned, SW::block>{});
+    }
+    for (std::size_t i = 0; w < full; ++w, ++i)
+        count += SW::count(SW::eq_mask(SW::at(p, i), b));
+    if (unsigned rest = static_cast<unsigned>(n % SW::lanes))
+        count += SW::count(
+            SW::eq_mask(SW::at(p, full % SW::block), b) &
+            SW::first_lanes(rest));
+    return count;
+}
+
+/// Index of the first of the n values equal to v, or n.
+template <unsigned N>
+inline std::size_t stream_find_first_scalar(const unsigned char *p,
+                                            std::size_t n,
+                                            uint64_t v) noexcept {
+    using SW = StreamWindow<N>;
+    const uint64_t b = SW::broadcast(v);
+    const std::size_t windows = (n + SW::lanes - 1) / SW::lanes;
+    for (std::size_t w = 0; w < windows; ++w) {
+        uint64_t m = SW::eq_mask(SW::at(p, w), b);
+        if (m != 0) {
+            std::size_t i = w * SW::lanes +
+                            static_cast<std::size_t>(__builtin_ctzll(m)) / N;
+            return i < n ? i : n;
+        }
+    }
+    return n;
+}
+
+/// Set bit i of bitmap (bit i % 64 of word i / 64) iff value i < v, for
+/// the first n values; returns how many are set. The bitmap needs
+/// (n + 63) / 64 words.
+template <unsigned N>
+inline std::size_t stream_filter_lt_scalar(const unsigned char *p,
+                                           std::size_t n, uint64_t v,
+                                           uint64_t *bitmap) noexcept {
+    using SW = StreamWindow<N>;
+    const uint64_t b = SW::broadcast(v);
+    const std::size_t full = n / SW::lanes;
+    detail::BitmapWriter out(bitmap);
+    std::size_t count = 0, w = 0;
+    auto emit = [&](uint64_t m, unsigned lanes) {
+        count += SW::count(m);
+        out.put(SW::compress(m), lanes);
+    };
+    for (; w + SW::block <= full; w += SW::block, p += SW::stride_bits) {
+        detail::for_block<N>(
+            p,
+            [&](uint64_t x) { emit(SW::lt_mask(x, b), SW::lanes); },
+            std::make_integer_sequence<unsigned, SW::block>{});
+    }
+    for (std::size_t i = 0; w < full; ++w, ++i)
+        emit(SW::lt_mask(SW::at(p, i), b), SW::lanes);
+    if (unsigned rest = static_cast<unsigned>(n % SW::lanes))
+        emit(SW::lt_mask(SW::at(p, full % SW::block), b) &
+                 SW::first_lanes(rest),
+             rest);
+    out.finish();
+    return count;
+}
+
+#if SWAR_X86
+
+// ----- AVX2: 4 windows per step -----
+
+namespace detail {
+
+/// Windows [k, k + 4) of the block at p: a gather at the constant byte
+/// offsets, then per-window shifts.
+template <unsigned N, unsigned K>
+SWAR_TARGET("avx2")
+inline __m256i stream_windows_avx2(const unsigned char *p) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i offsets = _mm256_setr_epi64x(
+        (K + 0) * SW::stride_bits / 8, (K + 1) * SW::stride_bits / 8,
+        (K + 2) * SW::stride_bits / 8, (K + 3) * SW::stride_bits / 8);
+    const __m256i shifts = _mm256_setr_epi64x(
+        (K + 0) * SW::stride_bits % 8, (K + 1) * SW::stride_bits % 8,
+        (K + 2) * SW::stride_bits % 8, (K + 3) * SW::stride_bits % 8);
+    __m256i x = _mm256_i64gather_epi64(
+        reinterpret_cast<const long long *>(p), offsets, 1);
+    return _mm256_and_si256(_mm256_srlv_epi64(x, shifts),
+                            _mm256_set1_epi64x(static_cast<long long>(SW::all)));
+}
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline __m256i stream_eq_avx2(__m256i x, __m256i b) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i low = _mm256_set1_epi64x(static_cast<long long>(SW::low));
+    const __m256i high = _mm256_set1_epi64x(static_cast<long long>(SW::high));
+    __m256i y = _mm256_xor_si256(x, b);
+    __m256i t = _mm256_or_si256(
+        _mm256_add_epi64(_mm256_and_si256(y, low), low), y);
+    return _mm256_andnot_si256(t, high);
+}
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline __m256i stream_lt_avx2(__m256i x, __m256i b) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i low = _mm256_set1_epi64x(static_cast<long long>(SW::low));
+    const __m256i high = _mm256_set1_epi64x(static_cast<long long>(SW::high));
+    __m256i d = _mm256_sub_epi64(_mm256_or_si256(x, high),
+                                 _mm256_and_si256(b, low));
+    __m256i lt = _mm256_or_si256(
+        _mm256_andnot_si256(x, b),
+        _mm256_andnot_si256(_mm256_or_si256(_mm256_xor_si256(x, b), d), high));
+    return _mm256_and_si256(lt, high);
+}
+
+/// Sum of the N-bit lane counters of the four windows in acc.
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline std::size_t stream_sum_counters_avx2(__m256i acc) noexcept {
+    using SW = StreamWindow<N>;
+    alignas(32) uint64_t c[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(c), acc);
+    std::size_t sum = 0;
+    for (uint64_t x : c) {
+        for (unsigned l = 0; l < SW::lanes; ++l)
+            sum += (x >> (l * N)) & SW::lane_mask;
+    }
+    return sum;
+}
+
+} // namespace detail
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline std::size_t stream_count_eq_avx2(const unsigned char *p, std::size_t n,
+                                        uint64_t v) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i b = _mm256_set1_epi64x(
+        static_cast<long long>(SW::broadcast(v)));
+    // Each window lane keeps an N-bit counter of its matches; two adds per
+    // block, flushed before any counter can reach 2^N.
+    constexpr std::size_t flush_blocks = ((uint64_t(1) << N) - 1) / 2;
+    if constexpr (flush_blocks == 0)
+        return stream_count_eq_scalar<N>(p, n, v);
+    const std::size_t blocks = n / SW::lanes / SW::block;
+    std::size_t count = 0;
+    std::size_t blk = 0;
+    while (blk < blocks) {
+        __m256i acc = _mm256_setzero_si256();
+        std::size_t stop = blocks - blk < flush_blocks ? blocks
+                                                       : blk + flush_blocks;
+        for (; blk < stop; ++blk, p += SW::stride_bits) {
+            __m256i m0 = detail::stream_eq_avx2<N>(
+                detail::stream_windows_avx2<N, 0>(p), b);
+            __m256i m1 = detail::stream_eq_avx2<N>(
+                detail::stream_windows_avx2<N, 4>(p), b);
+            acc = _mm256_add_epi64(acc, _mm256_srli_epi64(m0, N - 1));
+            acc = _mm256_add_epi64(acc, _mm256_srli_epi64(m1, N - 1));
+        }
+        count += detail::stream_sum_counters_avx2<N>(acc);
+    }
+    return count + stream_count_eq_scalar<N>(
+                       p, n - blocks * SW::block * SW::lanes, v);
+}
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline std::size_t stream_find_first_avx2(const unsigned char *p,
+                                          std::size_t n, uint64_t v) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i b = _mm256_set1_epi64x(
+        static_cast<long long>(SW::broadcast(v)));
+    const std::size_t blocks = n / SW::lanes / SW::block;
+    constexpr std::size_t per_block = SW::block * SW::lanes;
+    std::size_t blk = 0;
+    for (; blk < blocks; ++blk, p += SW::stride_bits) {
+        __m256i m = _mm256_or_si256(
+            detail::stream_eq_avx2<N>(detail::stream_windows_avx2<N, 0>(p), b),
+            detail::stream_eq_avx2<N>(detail::stream_windows_avx2<N, 4>(p), b));
+        if (!_mm256_testz_si256(m, m))
+            return blk * per_block +
+                   stream_find_first_scalar<N>(p, per_block, v);
+    }
+    return blk * per_block +
+           stream_find_first_scalar<N>(p, n - blk * per_block, v);
+}
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline std::size_t stream_filter_lt_avx2(const unsigned char *p,
+                                         std::size_t n, uint64_t v,
+                                         uint64_t *bitmap) noexcept {
+    using SW = StreamWindow<N>;
+    const __m256i b = _mm256_set1_epi64x(
+        static_cast<long long>(SW::broadcast(v)));
+    const std::size_t blocks = n / SW::lanes / SW::block;
+    detail::BitmapWriter out(bitmap);
+    std::size_t count = 0;
+    alignas(32) uint64_t m[SW::block];
+    for (std::size_t blk = 0; blk < blocks; ++blk, p += SW::stride_bits) {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(m),
+                           detail::stream_lt_avx2<N>(
+                               detail::stream_windows_avx2<N, 0>(p), b));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(m + 4),
+                           detail::stream_lt_avx2<N>(
+                               detail::stream_windows_avx2<N, 4>(p), b));
+        for (uint64_t x : m) {
+            count += SW::count(x);
+            out.put(SW::compress(x), SW::lanes);
+        }
+    }
+    // The scalar tail starts on a bitmap bit that may not be word aligned;
+    // run it into a scratch bitmap and splice its bits in.
+    std::size_t done = blocks * SW::block * SW::lanes;
+    uint64_t tail[(SW::block * SW::lanes + 63) / 64 + 1] = {};
+    std::size_t rest = n - done;
+    count += stream_filter_lt_scalar<N>(p, rest, v, tail);
+    for (std::size_t i = 0; i < rest; i += 32) {
+        unsigned len = rest - i < 32 ? static_cast<unsigned>(rest - i) : 32;
+        out.put((tail[i / 64] >> (i % 64)) & ((uint64_t(1) << len) - 1), len);
+    }
+    out.finish();
+    return count;
+}
+
+#endif // SWAR_X86
+
+// ----- compile-time selected entry points -----
+
+/// Number of the n values of the stream at p equal to v.
+template <unsigned N>
+inline std::size_t stream_count_eq(const unsigned char *p, std::size_t n,
+                                   uint64_t v) noexcept {
+#if defined(__AVX2__)
+    return stream_count_eq_avx2<N>(p, n, v);
+#else
+    return stream_count_eq_scalar<N>(p, n, v);
+#endif
+}
+
+/// Index of the first of the n values of the stream at p equal to v, or n.
+template <unsigned N>
+inline std::size_t stream_find_first(const unsigned char *p, std::size_t n,
+                                     uint64_t v) noexcept {
+#if defined(__AVX2__)
+    return stream_find_first_avx2<N>(p, n, v);
+#else
+    return stream_find_first_scalar<N>(p, n, v);
+#endif
+}
+
+/// Bitmap of the n values of the stream at p that are < v; returns the
+/// number of bits set.
+template <unsigned N>
+inline std::size_t stream_filter_lt(const unsigned char *p, std::size_t n,
+                                    uint64_t v, uint64_t *bitmap) noexcept {
+#if defined(__AVX2__)
+    return stream_filter_lt_avx2<N>(p, n, v, bitmap);
+#else
+    return stream_filter_lt_scalar<N>(p, n, v, bitmap);
+#endif
+}
+
+} // namespace swar
@@ -0,0 +1,372 @@
+#pragma once
+
+#include "packed_word.hpp"
+#include <array>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SWAR_X86 1
+#include <immintrin.h>
+// Compile a kernel for a wider ISA than the translation unit targets, so
+// the runtime dispatcher (dispatch.hpp) can pick it without -m flags.
+#define SWAR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SWAR_X86 0
+#endif
+
+namespace swar {
+
+/// Scan kernels over a contiguous array of PackedWord<N>.
+///
+/// Each kernel tests every word for a lane equal to v and reports the
+/// first word that has one. The scalar kernel uses
+/// PackedWord::zero_lanes_mask; the vector backends work on 2 (SSE4.2),
+/// 4 (AVX2) or 8 (AVX-512) words per instruction with the any-zero test
+///   x  = word ^ broadcast(v)
+///   hz = (x - broadcast_one) & ~x & high_bits
+/// and finish the remainder with the scalar kernel. This is not the
+/// per-lane exact ~((x | high_bits) - broadcast_one) & high_bits that
+/// zero_lanes_mask computes: a borrow out of a zero lane can flag lanes
+/// above it, but the lowest flagged lane is always a real zero, so
+/// hz != 0 exactly when some lane matches. Both forms are three ALU ops
+/// and both are correct for a per-word hit test; the vector kernels keep
+/// the original form rather than churn code that only needs hit/no-hit.
+///
+/// scan_first_word picks the widest backend the translation unit is
+/// compiled for (-mavx2 / -mavx512f, SWAR_SIMD in CMake). The x86 vector
+/// kernels are always compiled via target attributes so dispatch.hpp can
+/// select one at runtime instead.
+/// The same guard-bit rule as PackedWord::contains applies: v must be
+/// <= max_safe_value.
+enum class ScanBackend { scalar, sse42, avx2, avx512 };
+
+#if defined(__AVX512F__)
+inline constexpr ScanBackend scan_backend = ScanBackend::avx512;
+#elif defined(__AVX2__)
+inline constexpr ScanBackend scan_backend = ScanBackend::avx2;
+#else
+inline constexpr ScanBackend scan_backend = ScanBackend::scalar;
+#endif
+
+/// Words one step of scan_first_word loads at once: a scan of fewer words
+/// never reaches a vector load.
+inline constexpr std::size_t scan_step_words =
+    scan_backend == ScanBackend::avx512 ? 8
+    : scan_backend == ScanBackend::avx2 ? 4
+                                        : 1;
+
+static_assert(sizeof(PackedWord<8>) == sizeof(uint64_t),
+              "scan kernels load PackedWord arrays as raw uint64_t");
+
+// ----- scalar -----
+
+/// Index of the first word in [first, n) with a lane equal to v, or n.
+template <unsigned N>
+inline std::size_t scan_first_word_scalar(const PackedWord<N> *words,
+                                          std::size_t first, std::size_t n,
+                                          uint64_t v) noexcept {
+    const uint64_t bcast = PackedWord<N>::broadcast(v).raw();
+    for (std::size_t i = first; i < n; ++i) {
+        if (PackedWord<N>(words[i].raw() ^ bcast).zero_lanes_mask() != 0)
+            return i;
+    }
+    return n;
+}
+
+#if SWAR_X86
+
+// ----- SSE4.2: 2 words per step -----
+
+template <unsigned N>
+SWAR_TARGET("sse4.2")
+inline std::size_t scan_first_word_sse42(const PackedWord<N> *words,
+                                         std::size_t n, uint64_t v) noexcept {
+    using W = PackedWord<N>;
+    const __m128i bcast = _mm_set1_epi64x(
+        static_cast<long long>(W::broadcast(v).raw()));
+    const __m128i ones = _mm_set1_epi64x(
+        static_cast<long long>(W::broadcast_one));
+    const __m128i high = _mm_set1_epi64x(
+        static_cast<long long>(W::high_bits));
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i)),
+            bcast);
+        __m128i hz = _mm_andnot_si128(x, _mm_sub_epi64(x, ones));
+        if (!_mm_testz_si128(hz, high))
+            return scan_first_word_scalar(words, i, i + 2, v);
+    }
+    return scan_first_word_scalar(words, i, n, v);
+}
+
+// ----- AVX2: 4 words per step -----
+
+template <unsigned N>
+SWAR_TARGET("avx2")
+inline std::size_t scan_first_word_avx2(const PackedWord<N> *words,
+                                        std::size_t n, uint64_t v) noexcept {
+    using W = PackedWord<N>;
+    const __m256i bcast = _mm256_set1_epi64x(
+        static_cast<long long>(W::broadcast(v).raw()));
+    const __m256i ones = _mm256_set1_epi64x(
+        static_cast<long long>(W::broadcast_one));
+    const __m256i high = _mm256_set1_epi64x(
+        static_cast<long long>(W::high_bits));
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i)),
+            bcast);
+        __m256i hz = _mm256_andnot_si256(x, _mm256_sub_epi64(x, ones));
+        if (!_mm256_testz_si256(hz, high))
+            return scan_first_word_scalar(words, i, i + 4, v);
+    }
+    return scan_first_word_scalar(words, i, n, v);
+}
+
+// ----- AVX-512: 8 words per step -----
+
+template <unsigned N>
+SWAR_TARGET("avx512f")
+inline std::size_t scan_first_word_avx512(const PackedWord<N> *words,
+                                          std::size_t n, uint64_t v) noexcept {
+    using W = PackedWord<N>;
+    const __m512i bcast = _mm512_set1_epi64(
+        static_cast<long long>(W::broadcast(v).raw()));
+    const __m512i ones = _mm512_set1_epi64(
+        static_cast<long long>(W::broadcast_one));
+    const __m512i high = _mm512_set1_epi64(
+        static_cast<long long>(W::high_bits));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_xor_si512(_mm512_loadu_si512(words + i), bcast);
+        // (x - ones) & ~x & high in one vpternlogq (truth table 0x20).
+        __m512i hz = _mm512_ternarylogic_epi64(_mm512_sub_epi64(x, ones), x,
+                                               high, 0x20);
+        __mmask8 hit = _mm512_test_epi64_mask(hz, hz);
+        if (hit)
+            return i + static_cast<std::size_t>(__builtin_ctz(hit));
+    }
+    return scan_first_word_scalar(words, i, n, v);
+}
+
+#endif // SWAR_X86
+
+// ============================================================
+// Bucket scan kernels (BucketedSet layout)
+// ============================================================
+
+/// Layout of a bucket word: Lanes lanes of LaneBits bits (top bit of each
+/// lane is the guard), with the occupied-lane count stored at bit
+/// count_shift = Lanes * LaneBits. Lanes [0, count) are occupied.
+template <unsigned LaneBits, unsigned Lanes>
+struct BucketLayout {
+    static_assert(LaneBits >= 2 && Lanes >= 1, "need a guard bit per lane");
+
+    static constexpr unsigned lane_bits = LaneBits;
+    static constexpr unsigned lanes = Lanes;
+    static constexpr unsigned count_shift = LaneBits * Lanes;
+    static constexpr unsigned count_bits = [] {
+        unsigned bits = 0;
+        while ((1u << bits) <= Lanes)
+            ++bits;
+        return bits;
+    }();
+    static_assert(count_shift + count_bits <= 64,
+                  "count field must fit above the lanes");
+
+    static constexpr uint64_t all_lanes = (uint64_t(1) << count_shift) - 1;
+    static constexpr uint64_t count_mask = ((uint64_t(1) << count_bits) - 1)
+                                           << count_shift;
+    static constexpr uint64_t broadcast_one =
+        make_broadcast_one<LaneBits>() & all_lanes;
+    static constexpr uint64_t high_bits = make_high_bits<LaneBits>() & all_lanes;
+
+    /// occupied_masks[c]: guard bits of lanes [0, c).
+    static constexpr std::array<uint64_t, Lanes + 1> occupied_masks = [] {
+        std::array<uint64_t, Lanes + 1> m{};
+        for (unsigned c = 1; c <= Lanes; ++c)
+            m[c] = m[c - 1] | (uint64_t(1) << (c * LaneBits - 1));
+        return m;
+    }();
+
+    /// Guard bits of the occupied lanes of b.
+    static constexpr uint64_t occupied_high(uint64_t b) noexcept {
+        return occupied_masks[b >> count_shift];
+    }
+
+    /// haszero over the occupied lanes of b; bits sit at guard positions.
+    static constexpr uint64_t match(uint64_t b, uint64_t lo) noexcept {
+        uint64_t x = (b & all_lanes) ^ (lo * broadcast_one);
+        return (x - broadcast_one) & ~x & occupied_high(b);
+    }
+};
+
+/// Index of the first bucket in [first, n) with an occupied lane equal
+/// to lo, or n.
+template <class L>
+inline std::size_t scan_first_bucket_scalar(const uint64_t *buckets,
+                                            std::size_t first, std::size_t n,
+                                            uint64_t lo) noexcept {
+    for (std::size_t i = first; i < n; ++i) {
+        if (L::match(buckets[i], lo) != 0)
+            return i;
+    }
+    return n;
+}
+
+#if SWAR_X86
+
+// The vector kernels build the occupied-guard mask per bucket from
+// count > i comparisons, one per lane.
+
+template <class L>
+SWAR_TARGET("sse4.2")
+inline std::size_t scan_first_bucket_sse42(const uint64_t *buckets,
+                                           std::size_t n,
+                                           uint64_t lo) noexcept {
+    const __m128i bcast = _mm_set1_epi64x(
+        static_cast<long long>(lo * L::broadcast_one));
+    const __m128i ones = _mm_set1_epi64x(
+        static_cast<long long>(L::broadcast_one));
+    const __m128i lanes = _mm_set1_epi64x(static_cast<long long>(L::all_lanes));
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(buckets + i));
+        __m128i cnt = _mm_srli_epi64(b, L::count_shift);
+        __m128i valid = _mm_setzero_si128();
+        for (unsigned l = 0; l < L::lanes; ++l)
+            valid = _mm_or_si128(
+                valid,
+                _mm_and_si128(
+                    _mm_cmpgt_epi64(cnt, _mm_set1_epi64x(l)),
+                    _mm_set1_epi64x(static_cast<long long>(
+                        uint64_t(1) << (l * L::lane_bits + L::lane_bits - 1)))));
+        __m128i x = _mm_xor_si128(_mm_and_si128(b, lanes), bcast);
+        __m128i hz = _mm_andnot_si128(x, _mm_sub_epi64(x, ones));
+        if (!_mm_testz_si128(hz, valid))
+            return scan_first_bucket_scalar<L>(buckets, i, i + 2, lo);
+    }
+    return scan_first_bucket_scalar<L>(buckets, i, n, lo);
+}
+
+template <class L>
+SWAR_TARGET("avx2")
+inline std::size_t scan_first_bucket_avx2(const uint64_t *buckets,
+                                          std::size_t n,
+                                          uint64_t lo) noexcept {
+    const __m256i bcast = _mm256_set1_epi64x(
+        static_cast<long long>(lo * L::broadcast_one));
+    const __m256i ones = _mm256_set1_epi64x(
+        static_cast<long long>(L::broadcast_one));
+    const __m256i lanes =
+        _mm256_set1_epi64x(static_cast<long long>(L::all_lanes));
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(buckets + i));
+        __m256i cnt = _mm256_srli_epi64(b, L::count_shift);
+        __m256i valid = _mm256_setzero_si256();
+        for (unsigned l = 0; l < L::lanes; ++l)
+            valid = _mm256_or_si256(
+                valid,
+                _mm256_and_si256(
+                    _mm256_cmpgt_epi64(cnt, _mm256_set1_epi64x(l)),
+                    _mm256_set1_epi64x(static_cast<long long>(
+                        uint64_t(1) << (l * L::lane_bits + L::lane_bits - 1)))));
+        __m256i x = _mm256_xor_si256(_mm256_and_si256(b, lanes), bcast);
+        __m256i hz = _mm256_andnot_si256(x, _mm256_sub_epi64(x, ones));
+        if (!_mm256_testz_si256(hz, valid))
+            return scan_first_bucket_scalar<L>(buckets, i, i + 4, lo);
+    }
+    return scan_first_bucket_scalar<L>(buckets, i, n, lo);
+}
+
+template <class L>
+SWAR_TARGET("avx512f")
+inline std::size_t scan_first_bucket_avx512(const uint64_t *buckets,
+                                            std::size_t n,
+                                            uint64_t lo) noexcept {
+    const __m512i bcast = _mm512_set1_epi64(
+        static_cast<long long>(lo * L::broadcast_one));
+    const __m512i ones = _mm512_set1_epi64(
+        static_cast<long long>(L::broadcast_one));
+    const __m512i lanes = _mm512_set1_epi64(static_cast<long long>(L::all_lanes));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i b = _mm512_loadu_si512(buckets + i);
+        // count > l  <=>  b >= (l + 1) << count_shift, since the lanes sit
+        // below the count field.
+        __m512i valid = _mm512_setzero_si512();
+        for (unsigned l = 0; l < L::lanes; ++l)
+            valid = _mm512_mask_or_epi64(
+                valid,
+                _mm512_cmpge_epu64_mask(
+                    b, _mm512_set1_epi64(static_cast<long long>(
+                           uint64_t(l + 1) << L::count_shift))),
+                valid,
+                _mm512_set1_epi64(static_cast<long long>(
+                    uint64_t(1) << (l * L::lane_bits + L::lane_bits - 1))));
+        __m512i x = _mm512_xor_si512(_mm512_and_si512(b, lanes), bcast);
+        // (x - ones) & ~x & valid in one vpternlogq (truth table 0x20).
+        __m512i hz = _mm512_ternarylogic_epi64(_mm512_sub_epi64(x, ones), x,
+                                               valid, 0x20);
+        __mmask8 hit = _mm512_test_epi64_mask(hz, hz);
+        if (hit)
+            return i + static_cast<std::size_t>(__builtin_ctz(hit));
+    }
+    return scan_first_bucket_scalar<L>(buckets, i, n, lo);
+}
+
+#endif // SWAR_X86
+
+// ----- compile-time selected entry points -----
+
+/// Index of the first word with a lane equal to v, or n if none.
+template <unsigned N>
+inline std::size_t scan_first_word(const PackedWord<N> *words, std::size_t n,
+                                   uint64_t v) noexcept {
+#if defined(__AVX512F__)
+    return scan_first_word_avx512(words, n, v);
+#elif defined(__AVX2__)
+    return scan_first_word_avx2(words, n, v);
+#else
+    return scan_first_word_scalar(words, 0, n, v);
+#endif
+}
+
+/// True if any lane of words[0, n) equals v.
+template <unsigned N>
+inline bool scan_contains(const PackedWord<N> *words, std::size_t n,
+                          uint64_t v) noexcept {
+    assert(v <= PackedWord<N>::max_safe_value);
+    return scan_first_word(words, n, v) != n;
+}
+
+/// Slot index (word * lanes + lane) of the first lane equal to v, or -1.
+template <unsigned N>
+inline int scan_find(const PackedWord<N> *words, std::size_t n,
+                     uint64_t v) noexcept {
+    assert(v <= PackedWord<N>::max_safe_value);
+    std::size_t wi = scan_first_word(words, n, v);
+    if (wi == n)
+        return -1;
+    return static_cast<int>(wi * PackedWord<N>::lanes) + words[wi].find(v);
+}
+
+/// Index of the first bucket with an occupied lane equal to lo, or n.
+template <class L>
+inline std::size_t scan_first_bucket(const uint64_t *buckets, std::size_t n,
+                                     uint64_t lo) noexcept {
+#if defined(__AVX512F__)
+    return scan_first_bucket_avx512<L>(buckets, n, lo);
+#elif defined(__AVX2__)
+    return scan_first_bucket_avx2<L>(buckets, n, lo);
+#else
+    return scan_first_bucket_scalar<L>(buckets, 0, n, lo);
+#endif
+}
+
+} // namespace swar
@@ -1,5 +1,5 @@
 #!/usr/bin/env python3
-"""Visualize comparison benchmarks: PackedSet vs std containers (fixed size=10)."""
+"""Visualize comparison benchmarks: PackedSet vs std containers across set sizes."""
 
 import json
 import re
@@ -8,7 +8,6 @@ import sys
 from pathlib import Path
 
 import matplotlib.pyplot as plt
-import numpy as np
 
 RESULTS_DIR = Path(__file__).parent.parent / "results"
 BENCH_FILE = RESULTS_DIR / "comparison_results.json"
@@ -20,43 +19,43 @@ CONTAINER_LABELS = {
     "UnorderedSet": "std::unordered_set",
     "Vector": "std::vector",
     "SortedVector": "sorted vector",
+    "SortedPackedSet": "SortedPackedSet<11>",
     "Array": "std::array",
 }
 
-CONTAINER_ORDER = ["PackedSet", "BucketedSet", "StdSet", "UnorderedSet", "Vector", "SortedVector", "Array"]
-COLORS = ["#2196F3", "#00BCD4", "#FF9800", "#4CAF50", "#E91E63", "#673AB7", "#9C27B0"]
+CONTAINER_ORDER = [
+    "PackedSet", "BucketedSet", "StdSet", "UnorderedSet", "Vector", "SortedVector", "Array", "SortedPackedSet",
+]
+COLORS = ["#2196F3", "#00BCD4", "#FF9800", "#4CAF50", "#E91E63", "#673AB7", "#9C27B0", "#795548"]
 
 
 def parse_name(name: str):
-    """Extract (operation, container) from e.g. 'BM_Insert_PackedSet'."""
-    m = re.match(r"BM_(\w+?)_(PackedSet|BucketedSet|StdSet|UnorderedSet|SortedVector|Vector|Array)$", name)
+    """Extract (operation, container, size) from e.g. 'BM_Insert_PackedSet<64>'."""
+    m = re.match(
+        r"BM_(\w+?)_(PackedSet|BucketedSet|StdSet|UnorderedSet|SortedPackedSet|SortedVector|Vector|Array)<(\d+)>$",
+        name,
+    )
     if m:
-        return m.group(1), m.group(2)
-    return None, None
-
+        return m.group(1), m.group(2), int(m.group(3))
+    return None, None, None
 
-def plot_operation(ax, data: dict, title: str):
-    """Horizontal bar chart: one bar per container, x=time(ns)."""
-    y = np.arange(len(CONTAINER_ORDER))
-    times = [data.get(c, 0) for c in CONTAINER_ORDER]
-    labels = [CONTAINER_LABELS[c] for c in CONTAINER_ORDER]
 
-    bars = ax.barh(y, times, color=COLORS, edgecolor="black", alpha=0.85)
-    ax.set_yticks(y)
-    ax.set_yticklabels(labels, fontsize=9)
-    ax.set_xlabel("Time (ns)")
+def plot_sweep(ax, data: dict, title: str, ylabel: str):
+    """Line chart: one line per container, x=set size (log2), y=value (log)."""
+    for container, color in zip(CONTAINER_ORDER, COLORS):
+        points = sorted(data.get(container, {}).items())
+        if not points:
+            continue
+        sizes, values = zip(*points)
+        ax.plot(sizes, values, marker="o", markersize=3, color=color,
+                label=CONTAINER_LABELS[container])
+    ax.set_xscale("log", base=2)
+    ax.set_yscale("log")
+    ax.set_xlabel("Set size")
+    ax.set_ylabel(ylabel)
     ax.set_title(title, fontsize=11)
-    ax.invert_yaxis()
-
-    for bar, t in zip(bars, times):
-        ax.text(
-            bar.get_width(),
-            bar.get_y() + bar.get_height() / 2,
-            f"  {t:.1f}",
-            ha="left",
-            va="center",
-            fontsize=8,
-        )
+    ax.grid(True, which="both", alpha=0.3)
+    ax.legend(fontsize=8)
 
 
 def run_benchmark():
@@ -91,70 +90,48 @@ def main():
     with open(BENCH_FILE) as f:
         raw = json.load(f)
 
-    # Group: ops[operation][container] = time_ns
-    ops: dict[str, dict[str, float]] = {}
+    # Group: ops[operation][container][size] = time_ns
+    ops: dict[str, dict[str, dict[int, float]]] = {}
+    memory: dict[str, dict[int, float]] = {}
     bench_n = None
-    bench_size = None
     for bm in raw.get("benchmarks", []):
-        op, container = parse_name(bm["name"])
+        op, container, size = parse_name(bm["name"])
         if op is None:
             continue
-        ops.setdefault(op, {})[container] = bm["real_time"]
+        if op == "Memory":
+            if "bytes" in bm:
+                memory.setdefault(container, {})[size] = bm["bytes"]
+            continue
+        ops.setdefault(op, {}).setdefault(container, {})[size] = bm["real_time"]
         if bench_n is None and "N" in bm:
             bench_n = int(bm["N"])
-        if bench_size is None and "size" in bm:
-            bench_size = int(bm["size"])
 
     n_str = str(bench_n) if bench_n is not None else "?"
-    sz_str = str(bench_size) if bench_size is not None else "?"
-
-    # Extract memory usage from Memory_* benchmarks
-    memory: dict[str, float] = {}
-    for bm in raw.get("benchmarks", []):
-        op, container = parse_name(bm["name"])
-        if op == "Memory" and container and "bytes" in bm:
-            memory[container] = bm["bytes"]
-
-    # Remove Memory from ops (it gets its own panel)
-    ops.pop("Memory", None)
 
     titles = {
-        "Insert": f"Insert {sz_str} Elements (N={n_str})",
-        "Contains": f"Contains — Hit (N={n_str}, size={sz_str})",
-        "ContainsMiss": f"Contains — Miss (N={n_str}, size={sz_str})",
-        "Erase": f"Erase (N={n_str}, size={sz_str})",
+        "Insert": f"Insert All Elements (N={n_str})",
+        "Contains": f"Contains — Hit (N={n_str})",
+        "ContainsMiss": f"Contains — Miss (N={n_str})",
+        "Erase": f"Erase (N={n_str})",
+        "Range": f"Count in Range (N={n_str})",
+        "Intersect": f"Intersect Two Sets, Half Shared (N={n_str})",
+        "IntersectSize": f"Intersection Size, Half Shared (N={n_str})",
+        "Iterate": f"Iterate All Elements (N={n_str})",
+        "ForEach": f"for_each Over All Elements (N={n_str})",
     }
 
     n_panels = len(ops) + (1 if memory else 0)
-    fig, axes = plt.subplots(n_panels, 1, figsize=(8, 3.5 * n_panels))
+    fig, axes = plt.subplots(n_panels, 1, figsize=(8, 4 * n_panels))
     if n_panels == 1:
         axes = [axes]
 
     for ax, (op, data) in zip(axes, sorted(ops.items())):
-        plot_operation(ax, data, titles.get(op, op))
+        plot_sweep(ax, data, titles.get(op, op), "Time (ns)")
 
     if memory:
-        ax_mem = axes[len(ops)]
-        y = np.arange(len(CONTAINER_ORDER))
-        mem_vals = [memory.get(c, 0) for c in CONTAINER_ORDER]
-        labels = [CONTAINER_LABELS[c] for c in CONTAINER_ORDER]
-        bars = ax_mem.barh(y, mem_vals, color=COLORS, edgecolor="black", alpha=0.85)
-        ax_mem.set_yticks(y)
-        ax_mem.set_yticklabels(labels, fontsize=9)
-        ax_mem.set_xlabel("Bytes")
-        ax_mem.set_title(f"Memory Usage (N={n_str}, size={sz_str})", fontsize=11)
-        ax_mem.invert_yaxis()
-        for bar, b in zip(bars, mem_vals):
-            ax_mem.text(
-                bar.get_width(),
-                bar.get_y() + bar.get_height() / 2,
-                f"  {b:.0f}",
-                ha="left",
-                va="center",
-                fontsize=8,
-            )
-
-    fig.suptitle(f"PackedSet<{n_str}> vs Standard Containers (size={sz_str})", fontsize=14)
+        plot_sweep(axes[len(ops)], memory, f"Memory Usage (N={n_str})", "Bytes")
+
+    fig.suptitle(f"PackedSet<{n_str}> vs Standard Containers by Set Size", fontsize=14)
     plt.tight_layout(rect=[0, 0, 1, 0.97])
 
     out = RESULTS_DIR / "comparison.png"
@@ -53,8 +53,11 @@ def plot_density():
 
 
 def parse_bench_name(name: str):
-    """Extract operation and N from benchmark name like 'BM_Broadcast<5>'."""
-    m = re.match(r"BM_(\w+)<(\d+)>", name)
+    """Extract operation and N from benchmark name like 'BM_Broadcast<5>'.
+
+    Capacity-parameterized scans ('BM_ScanVector<5>/256') are skipped.
+    """
+    m = re.match(r"BM_(\w+)<(\d+)>$", name)
     if m:
         return m.group(1), int(m.group(2))
     return None, None
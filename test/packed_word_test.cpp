@@ -1,8 +1,28 @@
+#include <swar/batch_lookup.hpp>
 #include <swar/bucketed_set.hpp>
+#include <swar/bulk_build.hpp>
+#include <swar/concurrent_bucketed_set.hpp>
+#include <swar/concurrent_packed_set.hpp>
+#include <swar/counted_packed_set.hpp>
+#include <swar/dispatch.hpp>
+#include <swar/packed_hash_set.hpp>
 #include <swar/packed_set.hpp>
+#include <swar/packed_set_arena.hpp>
+#include <swar/packed_vector.hpp>
 #include <swar/packed_word.hpp>
+#include <swar/sharded_packed_set.hpp>
+#include <swar/sorted_packed_set.hpp>
+#include <swar/word_scan.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
 
 using namespace swar;
 
@@ -203,6 +223,153 @@ TEST(PackedWordMinMax, AllSame) {
     EXPECT_EQ(w.max(), 42u);
 }
 
+// Reference min/max over lanes [0, count) with get().
+template <unsigned N> static void check_min_max(PackedWord<N> w) {
+    for (unsigned count = 1; count <= PackedWord<N>::lanes; ++count) {
+        uint64_t lo = w.get(0), hi = w.get(0);
+        for (unsigned i = 1; i < count; ++i) {
+            lo = std::min(lo, w.get(i));
+            hi = std::max(hi, w.get(i));
+        }
+        ASSERT_EQ(w.min(count), lo) << "N=" << N << " count=" << count;
+        ASSERT_EQ(w.max(count), hi) << "N=" << N << " count=" << count;
+    }
+}
+
+template <unsigned N> static void check_min_max_random() {
+    using W = PackedWord<N>;
+    std::mt19937_64 rng(N);
+    // Full N-bit lanes (guard bit included) plus the extremes.
+    check_min_max(W());
+    check_min_max(W::broadcast(W::lane_mask));
+    for (int iter = 0; iter < 2000; ++iter) {
+        // Narrow ranges make equal and adjacent lanes common.
+        uint64_t range =
+            (iter % 2) ? W::lane_mask : std::min<uint64_t>(3, W::lane_mask);
+        W w;
+        for (unsigned i = 0; i < W::lanes; ++i)
+            w = w.set(i, rng() % (range + 1));
+        // Unused high bits must not leak into the result.
+        check_min_max(W(w.raw() | ~W::all_lanes_mask));
+    }
+}
+
+TEST(PackedWordMinMax, MatchesReferenceAllN) {
+    check_min_max_random<1>();
+    check_min_max_random<3>();
+    check_min_max_random<5>();
+    check_min_max_random<6>();
+    check_min_max_random<7>();
+    check_min_max_random<8>();
+    check_min_max_random<9>();
+    check_min_max_random<10>();
+    check_min_max_random<11>();
+    check_min_max_random<12>();
+    check_min_max_random<13>();
+    check_min_max_random<14>();
+    check_min_max_random<21>();
+    check_min_max_random<32>();
+}
+
+TEST(PackedWordMinMax, Constexpr) {
+    constexpr auto w = PackedWord<9>().set(0, 300).set(1, 511).set(2, 4);
+    static_assert(w.min(2) == 300);
+    static_assert(w.min(3) == 4);
+    static_assert(w.max(3) == 511);
+}
+
+// ============================================================
+// Ordered comparison masks
+// ============================================================
+
+// MSB-of-lane mask built lane by lane from a predicate on (lane, other).
+template <unsigned N, class Pred>
+static uint64_t reference_mask(PackedWord<N> w, PackedWord<N> o, Pred pred) {
+    uint64_t m = 0;
+    for (unsigned i = 0; i < PackedWord<N>::lanes; ++i) {
+        if (pred(w.get(i), o.get(i)))
+            m |= uint64_t(1) << (i * N + N - 1);
+    }
+    return m;
+}
+
+template <unsigned N> static void check_compare_masks() {
+    using W = PackedWord<N>;
+    std::mt19937_64 rng(N);
+    auto random_word = [&] {
+        W w;
+        for (unsigned i = 0; i < W::lanes; ++i)
+            w = w.set(i, rng() % (W::max_safe_value + 1));
+        return w;
+    };
+    for (int iter = 0; iter < 500; ++iter) {
+        W w = random_word();
+        W o = random_word();
+        uint64_t v = rng() % (W::max_safe_value + 1);
+        W b = W::broadcast(v);
+        auto lt = [](uint64_t x, uint64_t y) { return x < y; };
+        auto gt = [](uint64_t x, uint64_t y) { return x > y; };
+        auto le = [](uint64_t x, uint64_t y) { return x <= y; };
+        auto ge = [](uint64_t x, uint64_t y) { return x >= y; };
+        ASSERT_EQ(w.less_than_mask(v), reference_mask(w, b, lt));
+        ASSERT_EQ(w.greater_than_mask(v), reference_mask(w, b, gt));
+        ASSERT_EQ(w.less_equal_mask(v), reference_mask(w, b, le));
+        ASSERT_EQ(w.greater_equal_mask(v), reference_mask(w, b, ge));
+        ASSERT_EQ(w.less_than_mask(o), reference_mask(w, o, lt));
+        ASSERT_EQ(w.greater_than_mask(o), reference_mask(w, o, gt));
+        ASSERT_EQ(w.less_equal_mask(o), reference_mask(w, o, le));
+        ASSERT_EQ(w.greater_equal_mask(o), reference_mask(w, o, ge));
+
+        uint64_t lo = rng() % (W::max_safe_value + 1);
+        uint64_t hi = rng() % (W::max_safe_value + 1);
+        ASSERT_EQ(w.in_range_mask(lo, hi),
+                  w.greater_equal_mask(lo) & w.less_equal_mask(hi));
+    }
+}
+
+TEST(PackedWordCompare, MatchesReferenceAllN) {
+    check_compare_masks<2>();
+    check_compare_masks<5>();
+    check_compare_masks<6>();
+    check_compare_masks<7>();
+    check_compare_masks<8>();
+    check_compare_masks<9>();
+    check_compare_masks<10>();
+    check_compare_masks<11>();
+    check_compare_masks<12>();
+    check_compare_masks<13>();
+    check_compare_masks<14>();
+    check_compare_masks<16>();
+    check_compare_masks<32>();
+}
+
+TEST(PackedWordCompare, CountLanes) {
+    using W5 = PackedWord<5>;
+    EXPECT_EQ(W5::count_lanes(0), 0u);
+    EXPECT_EQ(W5::count_lanes(W5::high_bits), W5::lanes);
+    EXPECT_EQ(W5::count_lanes(W5::high_bits & 0xFFFF), 3u);
+    using W4 = PackedWord<4>; // 16 lanes: falls back to popcount
+    EXPECT_EQ(W4::count_lanes(W4::high_bits), 16u);
+    std::mt19937_64 rng(9);
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t m = rng() & PackedWord<11>::high_bits;
+        EXPECT_EQ(PackedWord<11>::count_lanes(m),
+                  static_cast<unsigned>(__builtin_popcountll(m)));
+    }
+}
+
+TEST(PackedWordCompare, Extremes) {
+    using W = PackedWord<8>;
+    W w = W().set(0, 0).set(1, W::max_safe_value).set(2, 5);
+    // Lanes 3..7 are zero.
+    EXPECT_EQ(w.less_than_mask(1), W::high_bits & ~(uint64_t(1) << 15) &
+                                       ~(uint64_t(1) << 23));
+    EXPECT_EQ(w.greater_than_mask(W::max_safe_value), 0u);
+    EXPECT_EQ(w.greater_equal_mask(0), W::high_bits);
+    EXPECT_EQ(w.in_range_mask(5, 5), uint64_t(1) << 23);
+    EXPECT_EQ(w.in_range_mask(6, 4), 0u);
+}
+
 // ============================================================
 // PackedSet
 // ============================================================
@@ -270,6 +437,28 @@ TEST(PackedSet, SmallBitWidth) {
     }
 }
 
+TEST(PackedSet, CountInRange) {
+    PackedSet<11, 40> s;
+    std::set<uint16_t> ref;
+    std::mt19937 rng(3);
+    while (ref.size() < 30) {
+        auto v = static_cast<uint16_t>(1 + rng() % 1023);
+        ref.insert(v);
+        s.insert(v);
+    }
+    s.erase(*ref.begin());
+    ref.erase(ref.begin());
+    for (int iter = 0; iter < 200; ++iter) {
+        uint64_t lo = rng() % 1024, hi = rng() % 1024;
+        std::size_t expect = 0;
+        for (auto v : ref)
+            expect += v >= lo && v <= hi;
+        EXPECT_EQ(s.count_in_range(lo, hi), expect) << lo << ".." << hi;
+    }
+    EXPECT_EQ(s.count_in_range(0, 1023), ref.size());
+    EXPECT_EQ((PackedSet<11, 40>().count_in_range(0, 1023)), 0u);
+}
+
 // ============================================================
 // BucketedSet
 // ============================================================
@@ -371,3 +560,1730 @@ TEST(BucketedSet, BucketSpillover) {
         EXPECT_TRUE(s.contains(v)) << "missing " << v;
     }
 }
+
+TEST(BucketedSet, EraseReopensEarlierBucket) {
+    BucketedSet<9> s; // 3 buckets per half
+    for (uint16_t v = 1; v <= 9; ++v)
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(10)); // lo half full
+    EXPECT_TRUE(s.erase(2));    // frees a lane in bucket 0
+    EXPECT_TRUE(s.insert(10));
+    EXPECT_FALSE(s.insert(11));
+    EXPECT_FALSE(s.insert(5)); // duplicate, still rejected
+    for (uint16_t v : {1, 3, 4, 5, 6, 7, 8, 9, 10})
+        EXPECT_TRUE(s.contains(v)) << "missing " << v;
+    EXPECT_FALSE(s.contains(2));
+}
+
+TEST(BucketedSet, CursorSkipsReopenedGaps) {
+    BucketedSet<9> s;
+    for (uint16_t v = 1; v <= 7; ++v)
+        s.insert(v); // buckets 0,1 full, bucket 2 has one lane
+    EXPECT_TRUE(s.erase(1));   // bucket 0 back to 2 lanes
+    EXPECT_TRUE(s.insert(20)); // fills bucket 0 again
+    EXPECT_TRUE(s.insert(21)); // must skip full bucket 1 to bucket 2
+    EXPECT_TRUE(s.insert(22));
+    EXPECT_FALSE(s.insert(23));
+    for (uint16_t v : {2, 3, 4, 5, 6, 7, 20, 21, 22})
+        EXPECT_TRUE(s.contains(v)) << "missing " << v;
+}
+
+// ============================================================
+// BasicBucketedSet (generalized bit width / partitions)
+// ============================================================
+
+TEST(BasicBucketedSet, LayoutConstants) {
+    EXPECT_EQ(BucketedSet<5>::lanes_per_bucket, 3u);
+    EXPECT_EQ(BucketedSet<5>::partitions, 2u);
+    // Densest default: 5 x 11-bit lanes + 3-bit count.
+    EXPECT_EQ((BasicBucketedSet<11, 1, 5>::lanes_per_bucket), 5u);
+    EXPECT_EQ((BasicBucketedSet<16, 1, 64>::lane_bits), 16u);
+    EXPECT_EQ((BasicBucketedSet<16, 1, 64>::lanes_per_bucket), 3u);
+    EXPECT_EQ((BasicBucketedSet<16, 2, 64>::lanes_per_bucket), 4u);
+    EXPECT_EQ((BasicBucketedSet<16, 4, 64>::partitions), 16u);
+    EXPECT_EQ((BasicBucketedSet<16, 4, 64>::lane_bits), 13u);
+    EXPECT_EQ((BasicBucketedSet<12, 4, 64>::lanes_per_bucket), 6u);
+}
+
+template <unsigned V, unsigned P> void test_basic_bucketed_set() {
+    using S = BasicBucketedSet<V, P, 40>;
+    using T = typename S::value_type;
+    S s;
+    std::set<T> ref;
+    std::mt19937 rng(V * 31 + P);
+    std::uniform_int_distribution<uint32_t> dist(1, S::max_value);
+    for (int i = 0; i < 400; ++i) {
+        T v = static_cast<T>(dist(rng));
+        if (i % 3 == 2) {
+            EXPECT_EQ(s.erase(v), ref.erase(v) == 1) << "erase " << v;
+        } else if (ref.size() < 40 || ref.count(v)) {
+            bool fresh = !ref.count(v);
+            // Every partition holds Capacity values, so nothing is full.
+            EXPECT_EQ(s.insert(v), fresh) << "insert " << v;
+            ref.insert(v);
+        }
+    }
+    for (T v : ref)
+        EXPECT_TRUE(s.contains(v)) << "missing " << v;
+    for (int i = 0; i < 200; ++i) {
+        T v = static_cast<T>(dist(rng));
+        EXPECT_EQ(s.contains(v), ref.count(v) == 1) << v;
+    }
+}
+
+TEST(BasicBucketedSet, V12P2) { test_basic_bucketed_set<12, 2>(); }
+TEST(BasicBucketedSet, V14P3) { test_basic_bucketed_set<14, 3>(); }
+TEST(BasicBucketedSet, V16P1) { test_basic_bucketed_set<16, 1>(); }
+TEST(BasicBucketedSet, V16P4) { test_basic_bucketed_set<16, 4>(); }
+TEST(BasicBucketedSet, V20P4) { test_basic_bucketed_set<20, 4>(); }
+
+TEST(BasicBucketedSet, PartitionFull) {
+    // stored_bits=10; 2 lanes x 2 buckets = 4 values per partition
+    BasicBucketedSet<12, 2, 4, 2> s;
+    for (uint16_t v = 1; v <= 4; ++v)
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(5));           // partition 0 full
+    EXPECT_TRUE(s.insert(1024 + 5));     // partition 1 still empty
+    EXPECT_TRUE(s.insert(3 * 1024 + 0)); // stored value 0 in partition 3
+    EXPECT_TRUE(s.contains(3 * 1024));
+    EXPECT_FALSE(s.contains(2 * 1024));
+}
+
+// ============================================================
+// Batched lookups
+// ============================================================
+
+TEST(PackedSetBatch, ContainsManyMatchesContains) {
+    PackedSet<8, 20> s;
+    for (uint64_t v = 2; v <= 40; v += 2)
+        s.insert(v);
+    // 11 needles: two full groups of 4 plus a scalar tail of 3.
+    uint64_t needles[11] = {2, 3, 40, 41, 20, 21, 22, 1, 38, 39, 127};
+    bool out[11];
+    s.contains_many(needles, 11, out);
+    for (std::size_t i = 0; i < 11; ++i)
+        EXPECT_EQ(out[i], s.contains(needles[i])) << "needle " << needles[i];
+}
+
+TEST(PackedSetBatch, FindManyReturnsSlots) {
+    PackedSet<8, 20> s; // 8 lanes per word, 3 words
+    for (uint64_t v = 1; v <= 20; ++v)
+        s.insert(v);
+    uint64_t needles[6] = {1, 9, 20, 21, 8, 17};
+    int out[6];
+    s.find_many(needles, 6, out);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[1], 8);
+    EXPECT_EQ(out[2], 19);
+    EXPECT_EQ(out[3], -1);
+    EXPECT_EQ(out[4], 7);
+    EXPECT_EQ(out[5], 16);
+}
+
+TEST(BucketedSetBatch, ContainsManyMatchesContains) {
+    BucketedSet<9> s;
+    for (uint16_t v : {1, 500, 1023, 1024, 1500, 2047, 7, 8, 9})
+        s.insert(v);
+    uint16_t needles[10] = {1, 1024, 2, 2047, 1025, 500, 9, 10, 1500, 1023};
+    bool out[10];
+    s.contains_many(needles, 10, out);
+    for (std::size_t i = 0; i < 10; ++i)
+        EXPECT_EQ(out[i], s.contains(needles[i])) << "needle " << needles[i];
+}
+
+TEST(BucketedSetBatch, FindManyReturnsSlots) {
+    BucketedSet<6> s; // 2 buckets per half
+    for (uint16_t v : {1, 2, 3, 4, 1024, 1025})
+        s.insert(v);
+    uint16_t needles[5] = {1, 4, 1025, 5, 1024};
+    int out[5];
+    s.find_many(needles, 5, out);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[1], 3);  // lo half, bucket 1, lane 0
+    EXPECT_EQ(out[2], 7);  // hi half, bucket 0, lane 1
+    EXPECT_EQ(out[3], -1);
+    EXPECT_EQ(out[4], 6);
+}
+
+// ============================================================
+// Word scan
+// ============================================================
+
+template <unsigned N> void test_scan_matches_scalar() {
+    using W = PackedWord<N>;
+    // 19 words: exercises full AVX2/AVX-512 steps plus a scalar tail.
+    std::array<W, 19> words{};
+    uint64_t v = 1;
+    for (auto &w : words)
+        for (unsigned i = 0; i < W::lanes; ++i) {
+            w = w.set(i, v);
+            v = v % (W::max_safe_value - 1) + 1; // never max_safe_value
+        }
+    for (std::size_t wi : {0u, 3u, 4u, 9u, 16u, 18u}) {
+        std::array<W, 19> probe = words;
+        probe[wi] = probe[wi].set(W::lanes - 1, W::max_safe_value);
+        EXPECT_EQ(scan_first_word(probe.data(), probe.size(),
+                                  W::max_safe_value),
+                  wi) << "N=" << N;
+        EXPECT_EQ(scan_find(probe.data(), probe.size(), W::max_safe_value),
+                  static_cast<int>(wi * W::lanes + W::lanes - 1))
+            << "N=" << N;
+    }
+    EXPECT_FALSE(scan_contains(words.data(), words.size(), W::max_safe_value));
+    EXPECT_EQ(scan_find(words.data(), words.size(), W::max_safe_value), -1);
+}
+
+TEST(WordScan, N5) { test_scan_matches_scalar<5>(); }
+TEST(WordScan, N8) { test_scan_matches_scalar<8>(); }
+TEST(WordScan, N11) { test_scan_matches_scalar<11>(); }
+TEST(WordScan, N14) { test_scan_matches_scalar<14>(); }
+
+TEST(WordScan, PackedSetEraseUsesScan) {
+    PackedSet<8, 64> s; // 8 words
+    for (uint64_t v = 1; v <= 64; ++v)
+        s.insert(v);
+    EXPECT_TRUE(s.erase(50));
+    EXPECT_FALSE(s.contains(50));
+    EXPECT_TRUE(s.insert(100)); // reuses the freed lane
+    EXPECT_TRUE(s.contains(100));
+    EXPECT_FALSE(s.insert(101));
+}
+
+// ============================================================
+// Runtime dispatch
+// ============================================================
+
+static std::vector<ScanBackend> supported_backends() {
+    std::vector<ScanBackend> out;
+    for (auto b : {ScanBackend::scalar, ScanBackend::sse42, ScanBackend::avx2,
+                   ScanBackend::avx512})
+        if (b <= cpu_scan_backend())
+            out.push_back(b);
+    return out;
+}
+
+TEST(Dispatch, WordKernelsAgree) {
+    using W = PackedWord<11>;
+    std::array<W, 21> words{};
+    for (std::size_t i = 0; i < words.size(); ++i)
+        for (unsigned l = 0; l < W::lanes; ++l)
+            words[i] = words[i].set(l, 1 + (i * W::lanes + l) % 1000);
+    for (auto b : supported_backends()) {
+        auto fn = word_scan_kernel<11>(b);
+        for (uint64_t v : {1u, 5u, 500u, 999u, 1000u, 1001u, 1023u})
+            EXPECT_EQ(fn(words.data(), words.size(), v),
+                      scan_first_word_scalar(words.data(), 0, words.size(), v))
+                << "backend=" << static_cast<int>(b) << " v=" << v;
+    }
+}
+
+TEST(Dispatch, BucketKernelsAgree) {
+    using L = BucketLayout<11, 3>;
+    // 19 buckets with counts cycling 0..3; empty lanes hold stale values
+    // that must not match.
+    std::array<uint64_t, 19> buckets{};
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        uint64_t cnt = i % 4;
+        uint64_t b = cnt << L::count_shift;
+        for (unsigned l = 0; l < 3; ++l)
+            b |= uint64_t(1 + (i * 3 + l) % 1023) << (l * 11);
+        buckets[i] = b;
+    }
+    for (auto b : supported_backends()) {
+        auto fn = bucket_scan_kernel<L>(b);
+        for (uint64_t lo = 1; lo < 64; ++lo)
+            EXPECT_EQ(fn(buckets.data(), buckets.size(), lo),
+                      scan_first_bucket_scalar<L>(buckets.data(), 0,
+                                                  buckets.size(), lo))
+                << "backend=" << static_cast<int>(b) << " lo=" << lo;
+    }
+}
+
+TEST(Dispatch, ForceRejectsUnsupportedTier) {
+    for (auto b : supported_backends())
+        EXPECT_TRUE(force_word_scan_backend<11>(b));
+    if (cpu_scan_backend() != ScanBackend::avx512) {
+        EXPECT_FALSE(force_word_scan_backend<11>(ScanBackend::avx512));
+    }
+    force_word_scan_backend<11>(cpu_scan_backend());
+}
+
+TEST(Dispatch, ForceWhileScanning) {
+    using W = PackedWord<11>;
+    std::array<W, 16> words{};
+    words[13] = words[13].set(2, 77);
+    std::atomic<bool> stop{false};
+    std::thread scanner([&] {
+        while (!stop.load())
+            ASSERT_EQ(scan_first_word_dispatch(words.data(), words.size(), 77),
+                      13u);
+    });
+    for (int round = 0; round < 200; ++round)
+        for (auto b : supported_backends())
+            force_word_scan_backend<11>(b);
+    stop.store(true);
+    scanner.join();
+    force_word_scan_backend<11>(cpu_scan_backend());
+}
+
+TEST(Dispatch, LargeBucketedSet) {
+    BucketedSet<30> s; // 10 buckets per half: takes the dispatched scan
+    for (uint16_t v = 1; v <= 30; ++v) {
+        EXPECT_TRUE(s.insert(v));
+        EXPECT_TRUE(s.insert(static_cast<uint16_t>(v + 1024)));
+    }
+    EXPECT_TRUE(s.erase(17));
+    for (uint16_t v = 1; v <= 30; ++v) {
+        EXPECT_EQ(s.contains(v), v != 17) << v;
+        EXPECT_TRUE(s.contains(static_cast<uint16_t>(v + 1024))) << v;
+    }
+    EXPECT_FALSE(s.contains(31));
+}
+
+// ============================================================
+// CountedPackedSet
+// ============================================================
+
+TEST(CountedPackedSet, TracksSize) {
+    CountedPackedSet<8, 20> s;
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(s.insert(10));
+    EXPECT_TRUE(s.insert(20));
+    EXPECT_FALSE(s.insert(10));
+    EXPECT_EQ(s.size(), 2u);
+    EXPECT_TRUE(s.erase(10));
+    EXPECT_FALSE(s.erase(10));
+    EXPECT_EQ(s.size(), 1u);
+    EXPECT_TRUE(s.contains(20));
+    EXPECT_FALSE(s.contains(10));
+}
+
+TEST(CountedPackedSet, FullAtCapacity) {
+    // 8 lanes per word, capacity 20 -> 3 words with 4 spare lanes that
+    // must not be used.
+    CountedPackedSet<8, 20> s;
+    for (uint64_t v = 1; v <= 20; ++v)
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_TRUE(s.full());
+    EXPECT_FALSE(s.insert(21));
+    EXPECT_EQ(s.size(), 20u);
+    for (uint64_t v = 1; v <= 20; ++v)
+        EXPECT_TRUE(s.contains(v)) << "missing " << v;
+}
+
+TEST(CountedPackedSet, ReusesFreedLaneAndShrinksUsedWords) {
+    CountedPackedSet<8, 32> s; // 4 words
+    for (uint64_t v = 1; v <= 17; ++v)
+        s.insert(v);
+    EXPECT_EQ(s.used_words(), 3u);
+    // Free a lane in word 0: the next insert lands there, not in word 2.
+    EXPECT_TRUE(s.erase(3));
+    EXPECT_TRUE(s.insert(100));
+    EXPECT_EQ(s.words()[0].get(2), 100u);
+    // Emptying the last used word shrinks the scanned prefix.
+    EXPECT_TRUE(s.erase(17));
+    EXPECT_EQ(s.used_words(), 2u);
+    EXPECT_FALSE(s.contains(17));
+    EXPECT_TRUE(s.contains(16));
+}
+
+TEST(CountedPackedSet, ManyWordsBitmap) {
+    // 5 lanes per word at N=11: 600 elements span 120 words, so the
+    // free-word bitmap needs two uint64_t.
+    CountedPackedSet<11, 600> s;
+    for (uint64_t v = 1; v <= 600; ++v)
+        ASSERT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(601));
+    EXPECT_TRUE(s.erase(598));
+    EXPECT_TRUE(s.insert(601));
+    EXPECT_TRUE(s.contains(601));
+    EXPECT_FALSE(s.contains(598));
+}
+
+// ============================================================
+// PackedHashSet
+// ============================================================
+
+TEST(PackedHashSet, InsertContainsErase) {
+    PackedHashSet<11, 100> s;
+    EXPECT_TRUE(s.insert(5));
+    EXPECT_TRUE(s.insert(1023));
+    EXPECT_FALSE(s.insert(5));
+    EXPECT_EQ(s.size(), 2u);
+    EXPECT_TRUE(s.contains(5));
+    EXPECT_TRUE(s.contains(1023));
+    EXPECT_FALSE(s.contains(6));
+    EXPECT_TRUE(s.erase(5));
+    EXPECT_FALSE(s.erase(5));
+    EXPECT_FALSE(s.contains(5));
+    EXPECT_EQ(s.size(), 1u);
+}
+
+TEST(PackedHashSet, FillToCapacity) {
+    PackedHashSet<14, 1000> s;
+    for (uint64_t v = 1; v <= 1000; ++v)
+        ASSERT_TRUE(s.insert(v * 7));
+    EXPECT_FALSE(s.insert(8000)); // at capacity
+    for (uint64_t v = 1; v <= 1000; ++v)
+        EXPECT_TRUE(s.contains(v * 7)) << v * 7;
+    EXPECT_FALSE(s.contains(7001));
+}
+
+TEST(PackedHashSet, SingleGroupProbesWrap) {
+    // Capacity 3 at N=11 (5 lanes) needs one group; every value collides.
+    PackedHashSet<11, 3> s;
+    EXPECT_EQ(s.group_count(), 1u);
+    EXPECT_TRUE(s.insert(1));
+    EXPECT_TRUE(s.insert(2));
+    EXPECT_TRUE(s.insert(3));
+    EXPECT_FALSE(s.insert(4));
+    EXPECT_TRUE(s.erase(2));
+    EXPECT_TRUE(s.insert(4));
+    EXPECT_TRUE(s.contains(4));
+}
+
+TEST(PackedHashSet, MatchesReferenceUnderChurn) {
+    PackedHashSet<11, 200> s;
+    std::set<uint16_t> ref;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<uint16_t> dist(1, 1023);
+    for (int i = 0; i < 5000; ++i) {
+        uint16_t v = dist(rng);
+        if (rng() % 2) {
+            bool expect = ref.size() < 200 && !ref.count(v);
+            EXPECT_EQ(s.insert(v), expect) << "insert " << v;
+            if (expect)
+                ref.insert(v);
+        } else {
+            EXPECT_EQ(s.erase(v), ref.erase(v) == 1) << "erase " << v;
+        }
+    }
+    EXPECT_EQ(s.size(), ref.size());
+    for (uint16_t v = 1; v <= 1023; ++v)
+        EXPECT_EQ(s.contains(v), ref.count(v) == 1) << v;
+}
+
+// ============================================================
+// PackedSetArena
+// ============================================================
+
+TEST(PackedSetArena, StrideLayout) {
+    // PackedSet<11, 12>: 3 words, 5 lanes each.
+    static_assert(PackedSetArena<11, 12>::stride == 3);
+    static_assert(PackedSetArena<11, 12, true>::stride == 4);
+    static_assert(PackedSetArena<11, 5, true>::stride == 1);
+    static_assert(PackedSetArena<11, 50, true>::stride == 16);
+    static_assert(PackedSetArena<11, 12, true>::bytes_per_set() == 32);
+
+    PackedSetArena<11, 12, true> a(10);
+    auto base = reinterpret_cast<uintptr_t>(a.set_words(0));
+    EXPECT_EQ(base % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.set_words(3)) - base, 3u * 32);
+}
+
+TEST(PackedSetArena, SetsAreIndependent) {
+    PackedSetArena<11, 12> a;
+    auto h0 = a.create();
+    auto h1 = a.create();
+    EXPECT_EQ(h0, 0u);
+    EXPECT_EQ(h1, 1u);
+    EXPECT_EQ(a.set_count(), 2u);
+
+    EXPECT_TRUE(a.insert(h0, 7));
+    EXPECT_FALSE(a.insert(h0, 7));
+    EXPECT_TRUE(a.contains(h0, 7));
+    EXPECT_FALSE(a.contains(h1, 7));
+    for (uint64_t v = 1; v <= 15; ++v) // 3 words x 5 lanes
+        EXPECT_TRUE(a.insert(h1, v));
+    EXPECT_FALSE(a.insert(h1, 16)); // full
+    EXPECT_EQ(a.set_words(h0)[1].raw(), 0u);
+
+    EXPECT_TRUE(a.erase(h1, 7));
+    EXPECT_FALSE(a.erase(h1, 7));
+    EXPECT_TRUE(a.contains(h0, 7));
+    a.clear(h0);
+    EXPECT_FALSE(a.contains(h0, 7));
+}
+
+TEST(PackedSetArena, MatchesPackedSet) {
+    constexpr std::size_t sets = 100;
+    PackedSetArena<11, 12> a(sets);
+    PackedSetArena<11, 12, true> aligned(sets);
+    std::vector<PackedSet<11, 12>> ref(sets);
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint16_t> dist(1, 63);
+    for (int i = 0; i < 5000; ++i) {
+        auto h = static_cast<uint32_t>(rng() % sets);
+        uint16_t v = dist(rng);
+        if (rng() % 3) {
+            bool expect = ref[h].insert(v);
+            EXPECT_EQ(a.insert(h, v), expect);
+            EXPECT_EQ(aligned.insert(h, v), expect);
+        } else {
+            bool expect = ref[h].erase(v);
+            EXPECT_EQ(a.erase(h, v), expect);
+            EXPECT_EQ(aligned.erase(h, v), expect);
+        }
+    }
+
+    std::vector<uint32_t> handles(777);
+    std::vector<uint64_t> values(handles.size());
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        handles[i] = static_cast<uint32_t>(rng() % sets);
+        values[i] = dist(rng);
+    }
+    std::unique_ptr<bool[]> out(new bool[handles.size()]);
+    std::unique_ptr<bool[]> out_aligned(new bool[handles.size()]);
+    a.contains_many(handles.data(), values.data(), handles.size(), out.get());
+    aligned.contains_many(handles.data(), values.data(), handles.size(),
+                          out_aligned.get());
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        bool expect = ref[handles[i]].contains(values[i]);
+        EXPECT_EQ(out[i], expect) << i;
+        EXPECT_EQ(out_aligned[i], expect) << i;
+    }
+}
+
+// ============================================================
+// SortedPackedSet
+// ============================================================
+
+TEST(SortedPackedSet, KeepsLanesOrderedAcrossWords) {
+    SortedPackedSet<11, 12> s; // 3 words x 5 lanes
+    for (uint64_t v : {50, 10, 30, 20, 40, 60, 5, 55})
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(30));
+    EXPECT_EQ(s.size(), 8u);
+    std::vector<uint64_t> got;
+    for (std::size_t i = 0; i < s.size(); ++i)
+        got.push_back(s.at(i));
+    EXPECT_EQ(got, (std::vector<uint64_t>{5, 10, 20, 30, 40, 50, 55, 60}));
+    EXPECT_EQ(s.words()[1].get(0), 50u); // spilled into word 1
+    EXPECT_EQ(s.words()[1].get(3), 0u);
+    EXPECT_EQ(s.min(), 5u);
+    EXPECT_EQ(s.max(), 60u);
+
+    EXPECT_TRUE(s.erase(5));
+    EXPECT_FALSE(s.erase(5));
+    EXPECT_EQ(s.at(0), 10u);
+    EXPECT_EQ(s.words()[0].get(4), 50u); // pulled back from word 1
+    EXPECT_EQ(s.size(), 7u);
+}
+
+TEST(SortedPackedSet, RankAndRange) {
+    SortedPackedSet<11, 20> s;
+    for (uint64_t v = 10; v <= 100; v += 10)
+        s.insert(v);
+    EXPECT_EQ(s.rank(1), 0u);
+    EXPECT_EQ(s.rank(10), 0u);
+    EXPECT_EQ(s.rank(11), 1u);
+    EXPECT_EQ(s.rank(100), 9u);
+    EXPECT_EQ(s.rank(1023), 10u);
+    EXPECT_EQ(s.upper_bound(100), 10u);
+    EXPECT_EQ(s.upper_bound(1023), 10u);
+    EXPECT_EQ(s.range(25, 60), (std::pair<std::size_t, std::size_t>{2, 6}));
+    EXPECT_EQ(s.count_in_range(10, 10), 1u);
+    EXPECT_EQ(s.count_in_range(60, 25), 0u);
+    EXPECT_EQ(s.count_in_range(0, 1023), 10u);
+}
+
+TEST(SortedPackedSet, FullSetRejectsInsert) {
+    SortedPackedSet<11, 7> s;
+    for (uint64_t v = 7; v >= 1; --v)
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(8));
+    EXPECT_EQ(s.at(6), 7u);
+    EXPECT_TRUE(s.erase(1));
+    EXPECT_TRUE(s.insert(8));
+    EXPECT_EQ(s.max(), 8u);
+}
+
+template <unsigned N, std::size_t Capacity>
+static void check_sorted_against_std_set(uint32_t seed) {
+    using S = SortedPackedSet<N, Capacity>;
+    S s;
+    std::set<uint64_t> ref;
+    std::mt19937 rng(seed);
+    auto value = [&] { return 1 + rng() % PackedWord<N>::max_safe_value; };
+    for (int i = 0; i < 3000; ++i) {
+        uint64_t v = value();
+        if (rng() % 3) {
+            bool expect = ref.size() < Capacity && !ref.count(v);
+            ASSERT_EQ(s.insert(v), expect) << "insert " << v;
+            if (expect)
+                ref.insert(v);
+        } else {
+            ASSERT_EQ(s.erase(v), ref.erase(v) == 1) << "erase " << v;
+        }
+        ASSERT_EQ(s.size(), ref.size());
+        uint64_t q = rng() % (PackedWord<N>::max_safe_value + 1);
+        auto lb = static_cast<std::size_t>(
+            std::distance(ref.begin(), ref.lower_bound(q)));
+        ASSERT_EQ(s.lower_bound(q), lb) << q;
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1) << v;
+    }
+    std::size_t i = 0;
+    for (auto v : ref)
+        ASSERT_EQ(s.at(i++), v);
+    // Slots past size() stay zero.
+    for (std::size_t slot = ref.size(); slot < S::num_words * S::lanes_per_word;
+         ++slot)
+        ASSERT_EQ(s.words()[slot / S::lanes_per_word].get(
+                      static_cast<unsigned>(slot % S::lanes_per_word)),
+                  0u);
+}
+
+TEST(SortedPackedSet, MatchesStdSet) {
+    check_sorted_against_std_set<5, 15>(1);
+    check_sorted_against_std_set<8, 40>(2);
+    check_sorted_against_std_set<11, 64>(3);
+    check_sorted_against_std_set<14, 33>(4);
+    check_sorted_against_std_set<16, 100>(5);
+}
+
+// ============================================================
+// Set algebra
+// ============================================================
+
+TEST(PackedWordAlgebra, MatchAnyMask) {
+    using W = PackedWord<11>;
+    W a = W().set(0, 7).set(1, 9).set(3, 4); // lane 2 and 4 empty
+    W b = W().set(2, 4).set(4, 7);
+    EXPECT_EQ(a.match_any_mask(b),
+              (uint64_t(1) << 10) | (uint64_t(1) << 43)); // lanes 0 and 3
+    EXPECT_EQ(a.rotate_lanes(1).get(0), 9u);
+    EXPECT_EQ(a.rotate_lanes(1).get(4), 7u);
+    // Zero lanes of the left operand never match, even against zeros.
+    EXPECT_EQ(W().match_any_mask(W()), 0u);
+}
+
+template <class Set, class Ref>
+static void expect_same_values(const Set &s, const Ref &ref, uint64_t max_value) {
+    for (uint64_t v = 1; v <= max_value; ++v)
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1) << v;
+}
+
+template <class A, class B>
+static void check_packed_algebra(std::size_t na, std::size_t nb, uint32_t seed) {
+    constexpr uint64_t max_value = 300;
+    A a;
+    B b;
+    std::set<uint64_t> ra, rb;
+    std::mt19937 rng(seed);
+    while (ra.size() < na) {
+        uint64_t v = 1 + rng() % max_value;
+        if (ra.insert(v).second) {
+            ASSERT_TRUE(a.insert(v));
+        }
+    }
+    // Half of b comes from a.
+    for (auto v : ra) {
+        if (rb.size() < nb / 2 && rng() % 2 && rb.insert(v).second) {
+            ASSERT_TRUE(b.insert(v));
+        }
+    }
+    while (rb.size() < nb) {
+        uint64_t v = 1 + rng() % max_value;
+        if (rb.insert(v).second) {
+            ASSERT_TRUE(b.insert(v));
+        }
+    }
+    // Leave holes in both.
+    a.erase(*ra.begin());
+    ra.erase(ra.begin());
+    b.erase(*rb.rbegin());
+    rb.erase(std::prev(rb.end()));
+
+    std::set<uint64_t> inter, diff, uni;
+    std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                          std::inserter(inter, inter.end()));
+    std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                        std::inserter(diff, diff.end()));
+    std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                   std::inserter(uni, uni.end()));
+
+    EXPECT_EQ(a.intersection_size(b), inter.size());
+    EXPECT_EQ(b.intersection_size(a), inter.size());
+    expect_same_values(a.intersect(b), inter, max_value);
+    expect_same_values(a.difference(b), diff, max_value);
+    expect_same_values(a.unite(b), uni, max_value);
+    EXPECT_EQ(a.is_subset_of(b), diff.empty());
+    EXPECT_TRUE(a.intersect(b).is_subset_of(a));
+    EXPECT_TRUE(a.intersect(b).is_subset_of(b));
+    EXPECT_TRUE(a.is_subset_of(a.unite(b)));
+    EXPECT_TRUE(b.is_subset_of(a.unite(b)));
+    EXPECT_EQ(a.difference(b).intersection_size(b), 0u);
+}
+
+TEST(PackedSetAlgebra, MatchesStdAlgorithms) {
+    for (uint32_t seed = 1; seed <= 20; ++seed) {
+        check_packed_algebra<PackedSet<11, 5>, PackedSet<11, 5>>(5, 5, seed);
+        check_packed_algebra<PackedSet<11, 40>, PackedSet<11, 17>>(40, 17,
+                                                                   seed);
+        check_packed_algebra<PackedSet<10, 64>, PackedSet<10, 64>>(60, 64,
+                                                                   seed);
+    }
+}
+
+TEST(PackedSetAlgebra, SubsetAndEmpty) {
+    PackedSet<11, 10> a, b;
+    EXPECT_TRUE(a.is_subset_of(b));
+    EXPECT_EQ(a.intersection_size(b), 0u);
+    for (uint64_t v : {3, 5, 8})
+        a.insert(v);
+    for (uint64_t v : {1, 3, 5, 8, 13})
+        b.insert(v);
+    EXPECT_TRUE(a.is_subset_of(b));
+    EXPECT_FALSE(b.is_subset_of(a));
+    EXPECT_EQ(b.intersection_size(a), 3u);
+    auto u = a.unite(b);
+    static_assert(decltype(u)::num_words == 4);
+    EXPECT_EQ(u.intersection_size(b), 5u);
+}
+
+TEST(BucketedSetAlgebra, MatchesStdAlgorithms) {
+    for (uint32_t seed = 1; seed <= 20; ++seed) {
+        check_packed_algebra<BucketedSet<5>, BucketedSet<5>>(5, 5, seed);
+        check_packed_algebra<BucketedSet<64>, BucketedSet<20>>(64, 20, seed);
+        check_packed_algebra<BasicBucketedSet<11, 2, 40>,
+                             BasicBucketedSet<11, 2, 40>>(40, 40, seed);
+    }
+}
+
+TEST(BucketedSetAlgebra, ZeroLowBitsAcrossPartitions) {
+    // 1024 is stored as lo = 0 in partition 1; an empty lane must not
+    // match it.
+    BucketedSet<6> a, b;
+    a.insert(1024);
+    a.insert(5);
+    b.insert(5);
+    EXPECT_EQ(a.intersection_size(b), 1u);
+    EXPECT_FALSE(a.is_subset_of(b));
+    b.insert(1024);
+    EXPECT_TRUE(a.is_subset_of(b));
+    EXPECT_TRUE(a.intersect(b).contains(1024));
+    EXPECT_FALSE(a.difference(b).contains(1024));
+}
+
+// ============================================================
+// PackedVector
+// ============================================================
+
+template <unsigned N> static void check_packed_vector(uint32_t seed) {
+    using V = PackedVector<N>;
+    std::mt19937_64 rng(seed);
+    V v;
+    std::vector<uint64_t> ref;
+    for (int i = 0; i < 300; ++i) {
+        uint64_t x = rng() & V::max_value;
+        v.push_back(x);
+        ref.push_back(x);
+    }
+    ASSERT_EQ(v.size(), ref.size());
+    // Random overwrites must not disturb the neighbours.
+    for (int i = 0; i < 500; ++i) {
+        std::size_t at = rng() % ref.size();
+        uint64_t x = rng() & V::max_value;
+        v.set(at, x);
+        ref[at] = x;
+    }
+    v.set(0, V::max_value);
+    ref[0] = V::max_value;
+    for (std::size_t i = 0; i < ref.size(); ++i)
+        ASSERT_EQ(v.get(i), ref[i]) << "N=" << N << " i=" << i;
+
+    // Every ragged head/tail combination around the unpack groups.
+    for (std::size_t begin = 0; begin < 20; ++begin) {
+        for (std::size_t end = begin; end <= ref.size();
+             end += 1 + end / 16) {
+            std::vector<uint64_t> out(end - begin);
+            v.decode(begin, end, out.data());
+            ASSERT_TRUE(std::equal(out.begin(), out.end(),
+                                   ref.begin() + begin))
+                << "N=" << N << " [" << begin << "," << end << ")";
+        }
+    }
+    if constexpr (N <= 16) {
+        std::vector<uint16_t> out16(ref.size() - 3);
+        v.decode(3, ref.size(), out16.data());
+        std::vector<uint32_t> out32(ref.size() - 5);
+        v.decode(5, ref.size(), out32.data());
+        for (std::size_t i = 0; i < out16.size(); ++i)
+            ASSERT_EQ(out16[i], ref[i + 3]) << "N=" << N;
+        for (std::size_t i = 0; i < out32.size(); ++i)
+            ASSERT_EQ(out32[i], ref[i + 5]) << "N=" << N;
+    }
+}
+
+TEST(PackedVector, MatchesReference) {
+    check_packed_vector<1>(1);
+    check_packed_vector<5>(2);
+    check_packed_vector<7>(3);
+    check_packed_vector<11>(4);
+    check_packed_vector<12>(5);
+    check_packed_vector<16>(6);
+    check_packed_vector<17>(7);
+    check_packed_vector<31>(8);
+    check_packed_vector<32>(9);
+    check_packed_vector<57>(10);
+}
+
+TEST(PackedVector, ResizeZeroFills) {
+    PackedVector<11> v(10);
+    for (std::size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(v.get(i), 0u);
+        v.set(i, 2047);
+    }
+    v.resize(3);
+    v.resize(20);
+    for (std::size_t i = 0; i < 3; ++i)
+        EXPECT_EQ(v.get(i), 2047u);
+    for (std::size_t i = 3; i < 20; ++i)
+        EXPECT_EQ(v.get(i), 0u) << i;
+    v.clear();
+    EXPECT_TRUE(v.empty());
+}
+
+TEST(PackedVector, DenseStorage) {
+    PackedVector<11> v(64 * 100);
+    // 100 * 11 words of values plus the padding words.
+    EXPECT_EQ(v.memory_bytes(),
+              (1100 + PackedVector<11>::pad_words) * sizeof(uint64_t));
+}
+
+template <unsigned N> static void check_vector_scan(uint32_t seed) {
+    using V = PackedVector<N>;
+    std::mt19937_64 rng(seed);
+    // Few distinct values so equality hits often; sizes cover partial
+    // windows and partial blocks.
+    const uint64_t range = std::min<uint64_t>(V::max_value, 40);
+    for (std::size_t n : {0, 1, 7, 63, 64, 65, 200, 517, 1500}) {
+        V vec;
+        std::vector<uint64_t> ref;
+        for (std::size_t i = 0; i < n; ++i) {
+            uint64_t x = rng() % 3 == 0 ? V::max_value - rng() % 2
+                                        : rng() % (range + 1);
+            vec.push_back(x);
+            ref.push_back(x);
+        }
+        std::vector<uint64_t> probes = {0, 1, range / 2, V::max_value,
+                                        V::max_value - 1};
+        for (uint64_t v : probes) {
+            std::size_t cnt = static_cast<std::size_t>(
+                std::count(ref.begin(), ref.end(), v));
+            ASSERT_EQ(vec.count_eq(v), cnt) << "N=" << N << " n=" << n;
+            ASSERT_EQ(stream_count_eq_scalar<N>(vec.bytes(), n, v), cnt);
+            std::size_t first = static_cast<std::size_t>(
+                std::find(ref.begin(), ref.end(), v) - ref.begin());
+            ASSERT_EQ(vec.find_first(v), first) << "N=" << N << " n=" << n;
+            ASSERT_EQ(stream_find_first_scalar<N>(vec.bytes(), n, v), first);
+
+            std::vector<uint64_t> bm(vec.bitmap_words() + 1, ~uint64_t(0));
+            std::vector<uint64_t> bm_scalar(bm);
+            std::size_t set = vec.filter_lt(v, bm.data());
+            std::size_t set_scalar =
+                stream_filter_lt_scalar<N>(vec.bytes(), n, v, bm_scalar.data());
+            std::size_t expect = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                bool lt = ref[i] < v;
+                expect += lt;
+                ASSERT_EQ((bm[i / 64] >> (i % 64)) & 1, uint64_t(lt))
+                    << "N=" << N << " n=" << n << " v=" << v << " i=" << i;
+            }
+            ASSERT_EQ(set, expect);
+            ASSERT_EQ(set_scalar, expect);
+            if (n % 64) {
+                ASSERT_EQ(bm[n / 64] >> (n % 64), 0u);
+            }
+            for (std::size_t w = 0; w < vec.bitmap_words(); ++w)
+                ASSERT_EQ(bm[w], bm_scalar[w]);
+        }
+    }
+}
+
+TEST(PackedVector, ScanMatchesReference) {
+    check_vector_scan<1>(1);
+    check_vector_scan<2>(2);
+    check_vector_scan<5>(3);
+    check_vector_scan<11>(4);
+    check_vector_scan<12>(5);
+    check_vector_scan<16>(6);
+    check_vector_scan<19>(7);
+    check_vector_scan<29>(8);
+    check_vector_scan<57>(9);
+}
+
+// ============================================================
+// Zero-test policies
+// ============================================================
+
+template <unsigned N, class Z> static void check_zero_policy(uint32_t seed) {
+    using W = PackedWord<N, Z>;
+    std::mt19937_64 rng(seed);
+    for (int iter = 0; iter < 2000; ++iter) {
+        // Lanes cluster around a few values (and 0, 1, max) so equal,
+        // adjacent and zero lanes are common.
+        uint64_t base = rng() % (W::max_safe_value + 1);
+        W w;
+        uint64_t ref[64];
+        for (unsigned i = 0; i < W::lanes; ++i) {
+            uint64_t pick = rng() % 4;
+            uint64_t x = pick == 0   ? 0
+                         : pick == 1 ? base
+                         : pick == 2 ? (base ^ 1) & W::max_safe_value
+                                     : rng() % (W::max_safe_value + 1);
+            if (rng() % 8 == 0)
+                x = W::max_safe_value;
+            w = w.set(i, x);
+            ref[i] = x;
+        }
+        uint64_t probes[] = {0, 1, base, (base ^ 1) & W::max_safe_value,
+                             W::max_safe_value};
+        for (uint64_t v : probes) {
+            unsigned cnt = 0, lt = 0, gt = 0;
+            int first = -1;
+            for (unsigned i = 0; i < W::lanes; ++i) {
+                if (ref[i] == v) {
+                    ++cnt;
+                    if (first < 0)
+                        first = static_cast<int>(i);
+                }
+                lt += ref[i] < v;
+                gt += ref[i] > v;
+            }
+            ASSERT_EQ(w.count_eq(v), cnt) << "N=" << N << " v=" << v;
+            ASSERT_EQ(w.find(v), first) << "N=" << N << " v=" << v;
+            ASSERT_EQ(w.contains(v), cnt > 0);
+            ASSERT_EQ(W::count_lanes(w.less_than_mask(v)), lt);
+            ASSERT_EQ(W::count_lanes(w.greater_than_mask(v)), gt);
+        }
+        unsigned zeros = 0;
+        for (unsigned i = 0; i < W::lanes; ++i)
+            zeros += ref[i] == 0;
+        ASSERT_EQ(W::count_lanes(w.zero_lanes_mask()), zeros);
+    }
+}
+
+template <unsigned... Ns> static void check_zero_policies() {
+    (check_zero_policy<Ns, GuardedZero>(Ns), ...);
+    (check_zero_policy<Ns, ExactZero>(Ns + 100), ...);
+}
+
+TEST(ZeroTest, MatchesReferenceForAllN) {
+    check_zero_policies<2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+                        21, 32>();
+}
+
+TEST(ZeroTest, ExactUsesFullRange) {
+    using W = PackedWord<11, ExactZero>;
+    static_assert(W::max_safe_value == 2047);
+    W w = W().set(0, 2047).set(1, 1024).set(2, 1023).set(3, 0);
+    EXPECT_TRUE(w.contains(2047));
+    EXPECT_EQ(w.find(1024), 1);
+    EXPECT_EQ(w.find(1023), 2);
+    EXPECT_EQ(w.find(0), 3);
+    EXPECT_FALSE(w.contains(2046));
+    EXPECT_EQ(w.less_than_mask(1024), (uint64_t(1) << 32) | (uint64_t(1) << 43) |
+                                          (uint64_t(1) << 54));
+}
+
+TEST(ZeroTest, GuardedCountIgnoresBorrow) {
+    // A zero lane right below a lane holding 1 used to borrow into it.
+    using W = PackedWord<8>;
+    W w = W().set(0, 5).set(1, 4);
+    EXPECT_EQ(w.count_eq(5), 1u);
+    EXPECT_EQ(W().set(0, 0).set(1, 1).set(2, 7).count_eq(0), 6u);
+}
+
+TEST(ZeroTest, ExactPackedSetStoresTopValues) {
+    PackedSet<11, 12, ExactZero> s;
+    std::set<uint64_t> ref;
+    for (uint64_t v : {2047, 1024, 1025, 1, 2046, 1023}) {
+        EXPECT_TRUE(s.insert(v));
+        ref.insert(v);
+    }
+    EXPECT_FALSE(s.insert(2047));
+    for (uint64_t v = 1; v <= 2047; ++v)
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1) << v;
+    EXPECT_EQ(s.count_in_range(1024, 2047), 4u);
+    EXPECT_TRUE(s.erase(2047));
+    EXPECT_FALSE(s.contains(2047));
+    PackedSet<11, 4, ExactZero> o;
+    o.insert(1024);
+    o.insert(2046);
+    EXPECT_EQ(s.intersection_size(o), 2u);
+    EXPECT_TRUE(o.is_subset_of(s));
+}
+
+// ============================================================
+// Lane compaction (compress / expand / unpack_all)
+// ============================================================
+
+template <unsigned N> static void check_lane_compaction(uint32_t seed) {
+    using W = PackedWord<N>;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint64_t> val(0, W::lane_mask);
+    std::uniform_int_distribution<uint64_t> bits;
+    for (int iter = 0; iter < 200; ++iter) {
+        W w;
+        for (unsigned i = 0; i < W::lanes; ++i)
+            w = w.set(i, val(rng));
+        // Stray bits outside the lane MSBs must be ignored.
+        uint64_t mask = bits(rng);
+        W packed, spread;
+        unsigned k = 0;
+        for (unsigned i = 0; i < W::lanes; ++i) {
+            if (mask & (uint64_t(1) << (i * N + N - 1))) {
+                packed = packed.set(k, w.get(i));
+                spread = spread.set(i, w.get(k));
+                ++k;
+            }
+        }
+        ASSERT_EQ(w.compress(mask), packed);
+        ASSERT_EQ(w.compress_scalar(mask), packed);
+        ASSERT_EQ(w.expand(mask), spread);
+        ASSERT_EQ(w.expand_scalar(mask), spread);
+        ASSERT_EQ(packed.expand(mask).compress(mask), packed);
+
+        uint32_t out32[W::lanes + 1];
+        out32[W::lanes] = 0xdeadbeef;
+        w.unpack_all(out32);
+        for (unsigned i = 0; i < W::lanes; ++i)
+            ASSERT_EQ(out32[i], w.get(i));
+        ASSERT_EQ(out32[W::lanes], 0xdeadbeefu);
+        if constexpr (N <= 16) {
+            uint16_t out16[W::lanes + 1];
+            out16[W::lanes] = 0xbeef;
+            w.unpack_all(out16);
+            for (unsigned i = 0; i < W::lanes; ++i)
+                ASSERT_EQ(out16[i], w.get(i));
+            ASSERT_EQ(out16[W::lanes], 0xbeef);
+        }
+        if constexpr (N <= 8) {
+            uint8_t out8[W::lanes];
+            w.unpack_all_scalar(out8);
+            for (unsigned i = 0; i < W::lanes; ++i)
+                ASSERT_EQ(out8[i], w.get(i));
+            w.unpack_all(out8);
+            for (unsigned i = 0; i < W::lanes; ++i)
+                ASSERT_EQ(out8[i], w.get(i));
+        }
+    }
+}
+
+TEST(PackedWordCompaction, MatchesReferenceForAllN) {
+    check_lane_compaction<1>(1);
+    check_lane_compaction<2>(2);
+    check_lane_compaction<3>(3);
+    check_lane_compaction<5>(5);
+    check_lane_compaction<7>(7);
+    check_lane_compaction<8>(8);
+    check_lane_compaction<11>(11);
+    check_lane_compaction<13>(13);
+    check_lane_compaction<16>(16);
+    check_lane_compaction<21>(21);
+    check_lane_compaction<32>(32);
+}
+
+TEST(PackedWordCompaction, CompressMatches) {
+    using W = PackedWord<8>;
+    W w = W().set(0, 1).set(1, 5).set(2, 3).set(3, 5).set(4, 9).set(5, 5);
+    uint64_t eq5 = W(w.raw() ^ W::broadcast(5).raw()).zero_lanes_mask();
+    W hits = w.compress(eq5);
+    EXPECT_EQ(hits, W().set(0, 5).set(1, 5).set(2, 5));
+    // Dropping the 5s keeps the other lanes in order.
+    W rest = w.compress(~eq5 & W::high_bits);
+    EXPECT_EQ(rest, W().set(0, 1).set(1, 3).set(2, 9));
+    EXPECT_EQ(rest.expand(~eq5 & W::high_bits),
+              W(w.raw() & ~W::lanes_of(eq5)));
+}
+
+// ============================================================
+// Iteration (begin/end, for_each)
+// ============================================================
+
+// Insert and erase random values, checking after every step that the
+// iterators and for_each visit exactly the stored values, once each.
+template <class Set>
+static void check_iteration(uint64_t max_value, std::size_t capacity,
+                            uint32_t seed) {
+    using It = typename Set::const_iterator;
+    using T = typename std::iterator_traits<It>::value_type;
+    static_assert(std::is_same_v<
+                  typename std::iterator_traits<It>::iterator_category,
+                  std::forward_iterator_tag>);
+    Set s;
+    EXPECT_TRUE(s.begin() == s.end());
+    std::set<uint64_t> ref;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint64_t> dist(1, max_value);
+    for (int step = 0; step < 400; ++step) {
+        uint64_t v = dist(rng);
+        if (ref.size() < capacity && rng() % 3 != 0) {
+            if (s.insert(static_cast<T>(v)))
+                ref.insert(v);
+        } else if (!ref.empty()) {
+            auto it = ref.begin();
+            std::advance(it, rng() % ref.size());
+            ASSERT_TRUE(s.erase(static_cast<T>(*it)));
+            ref.erase(it);
+        }
+        std::vector<uint64_t> seen(s.begin(), s.end());
+        std::sort(seen.begin(), seen.end());
+        ASSERT_EQ(seen, std::vector<uint64_t>(ref.begin(), ref.end()));
+        ASSERT_EQ(static_cast<std::size_t>(std::distance(s.begin(), s.end())),
+                  ref.size());
+        std::vector<uint64_t> each;
+        s.for_each([&](uint64_t x) { each.push_back(x); });
+        ASSERT_EQ(each, std::vector<uint64_t>(s.begin(), s.end()));
+    }
+}
+
+TEST(Iteration, PackedSet) {
+    check_iteration<PackedSet<11, 40>>(1023, 40, 1);
+    check_iteration<PackedSet<5, 12>>(15, 12, 2);
+    check_iteration<PackedSet<11, 40, ExactZero>>(2047, 40, 3);
+    check_iteration<PackedSet<32, 7>>(PackedWord<32>::max_safe_value, 7, 4);
+}
+
+TEST(Iteration, BucketedSet) {
+    check_iteration<BucketedSet<40>>(2047, 40, 5);
+    check_iteration<BasicBucketedSet<16, 3, 30>>(65535, 30, 6);
+    check_iteration<BasicBucketedSet<8, 2, 9>>(255, 9, 7);
+}
+
+TEST(Iteration, BucketedSetRestoresPartitionBit) {
+    BucketedSet<8> s;
+    for (uint16_t v : {1024, 1, 2047, 1023, 1500})
+        s.insert(v);
+    std::vector<uint16_t> seen;
+    for (auto v : s)
+        seen.push_back(v);
+    // Partition 0 first, then partition 1, each in insertion order.
+    EXPECT_EQ(seen, (std::vector<uint16_t>{1, 1023, 1024, 2047, 1500}));
+    auto it = s.begin();
+    EXPECT_EQ(*it++, 1u);
+    EXPECT_EQ(*it, 1023u);
+}
+
+// ============================================================
+// PackedSet erase policies
+// ============================================================
+
+// Slots [0, live_count()) hold values and every later slot is zero.
+template <class Set> static void expect_packed(const Set &s) {
+    constexpr unsigned L = Set::lanes_per_word;
+    for (std::size_t i = 0; i < Set::num_words * L; ++i) {
+        uint64_t v = s.words()[i / L].get(static_cast<unsigned>(i % L));
+        ASSERT_EQ(v != 0, i < s.live_count()) << "slot " << i;
+    }
+    ASSERT_EQ(s.live_words(), (s.live_count() + L - 1) / L);
+}
+
+template <class Z, uint64_t Max> static void check_compact_churn(uint32_t seed) {
+    using Set = PackedSet<11, 37, Z, EraseCompact>;
+    Set s;
+    std::set<uint64_t> ref;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint64_t> dist(1, Max);
+    for (int step = 0; step < 3000; ++step) {
+        uint64_t v = dist(rng);
+        if (rng() % 2) {
+            bool fits = ref.size() < Set::capacity;
+            ASSERT_EQ(s.insert(v), fits && ref.insert(v).second);
+        } else if (!ref.empty() && rng() % 4 != 0) {
+            auto it = ref.begin();
+            std::advance(it, rng() % ref.size());
+            ASSERT_TRUE(s.erase(*it));
+            ref.erase(it);
+        } else {
+            ASSERT_EQ(s.erase(v), ref.erase(v) == 1);
+        }
+        ASSERT_EQ(s.live_count(), ref.size());
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1);
+        expect_packed(s);
+    }
+    for (uint64_t v = 1; v <= Max; ++v)
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1) << v;
+}
+
+TEST(PackedSetErase, CompactMatchesReference) {
+    check_compact_churn<GuardedZero, 1023>(1);
+    check_compact_churn<ExactZero, 2047>(2);
+}
+
+TEST(PackedSetErase, InPlaceLayoutUnchanged) {
+    static_assert(sizeof(PackedSet<11, 10>) == 2 * sizeof(uint64_t));
+    static_assert(
+        std::is_same_v<PackedSet<11, 10>,
+                       PackedSet<11, 10, GuardedZero, EraseInPlace>>);
+    PackedSet<11, 10> s;
+    EXPECT_EQ(s.live_words(), 2u);
+    s.insert(5);
+    s.insert(6);
+    s.erase(5);
+    EXPECT_EQ(s.words()[0].get(0), 0u);
+    EXPECT_EQ(s.words()[0].get(1), 6u);
+}
+
+TEST(PackedSetErase, CompactMovesLastIntoHole) {
+    PackedSet<11, 10, GuardedZero, EraseCompact> s;
+    EXPECT_EQ(s.live_words(), 0u);
+    EXPECT_FALSE(s.contains(1));
+    for (uint64_t v = 1; v <= 7; ++v)
+        s.insert(v);
+    EXPECT_EQ(s.live_words(), 2u);
+    EXPECT_TRUE(s.erase(2));
+    EXPECT_EQ(s.words()[0].get(1), 7u);
+    EXPECT_EQ(s.live_words(), 2u);
+    EXPECT_TRUE(s.erase(6)); // the last value itself
+    EXPECT_EQ(s.live_words(), 1u);
+    EXPECT_EQ(s.words()[1].raw(), 0u);
+    EXPECT_TRUE(s.erase(7));
+    EXPECT_EQ(s.live_count(), 4u);
+    EXPECT_EQ(s.words()[0].get(1), 5u);
+    EXPECT_FALSE(s.contains(7));
+    expect_packed(s);
+}
+
+TEST(PackedSetErase, CompactAlgebraStaysPacked) {
+    using Set = PackedSet<11, 40, GuardedZero, EraseCompact>;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint64_t> dist(1, 60);
+    for (int iter = 0; iter < 50; ++iter) {
+        Set a, b;
+        std::set<uint64_t> ra, rb;
+        for (int k = 0; k < 30; ++k) {
+            uint64_t v = dist(rng), w = dist(rng);
+            if (a.insert(v))
+                ra.insert(v);
+            if (b.insert(w))
+                rb.insert(w);
+        }
+        for (int k = 0; k < 8; ++k) {
+            uint64_t v = dist(rng);
+            if (a.erase(v))
+                ra.erase(v);
+        }
+        std::vector<uint64_t> want;
+        auto check = [](const auto &s, const std::vector<uint64_t> &ref) {
+            expect_packed(s);
+            std::vector<uint64_t> got(s.begin(), s.end());
+            std::sort(got.begin(), got.end());
+            EXPECT_EQ(got, ref);
+        };
+        std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                              std::back_inserter(want));
+        check(a.intersect(b), want);
+        EXPECT_EQ(a.intersection_size(b), want.size());
+        want.clear();
+        std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                            std::back_inserter(want));
+        check(a.difference(b), want);
+        want.clear();
+        std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(),
+                       std::back_inserter(want));
+        check(a.unite(b), want);
+    }
+}
+
+// ============================================================
+// ConcurrentPackedSet
+// ============================================================
+
+// Every committed value of s, in slot order; fails on a pending lane.
+template <class Set>
+static std::vector<uint64_t> committed_values(const Set &s) {
+    std::vector<uint64_t> out;
+    for (std::size_t i = 0; i < Set::num_words; ++i) {
+        auto w = s.load_word(i);
+        for (unsigned k = 0; k < Set::lanes_per_word; ++k) {
+            uint64_t v = w.get(k);
+            EXPECT_LE(v, Set::max_safe_value) << "pending lane left behind";
+            if (v != 0)
+                out.push_back(v);
+        }
+    }
+    return out;
+}
+
+TEST(ConcurrentPackedSet, MatchesReferenceSingleThreaded) {
+    ConcurrentPackedSet<11, 40> s;
+    std::set<uint64_t> ref;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint64_t> dist(1, 100);
+    for (int step = 0; step < 5000; ++step) {
+        uint64_t v = dist(rng);
+        if (rng() % 2) {
+            bool fits = ref.size() < 40; // 8 words of 5 lanes
+            ASSERT_EQ(s.insert(v), fits && ref.insert(v).second) << v;
+        } else {
+            ASSERT_EQ(s.erase(v), ref.erase(v) == 1) << v;
+        }
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1);
+    }
+    auto vals = committed_values(s);
+    std::sort(vals.begin(), vals.end());
+    EXPECT_EQ(vals, std::vector<uint64_t>(ref.begin(), ref.end()));
+}
+
+TEST(ConcurrentPackedSet, TopValueAndFull) {
+    ConcurrentPackedSet<5, 3> s; // 1 word of 12 lanes
+    EXPECT_TRUE(s.insert(15));
+    EXPECT_TRUE(s.contains(15));
+    EXPECT_FALSE(s.contains(7)); // 7 | guard would be 15
+    for (uint64_t v = 1; v <= 11; ++v)
+        EXPECT_TRUE(s.insert(v));
+    EXPECT_FALSE(s.insert(12)); // every lane taken
+    EXPECT_TRUE(s.erase(4));
+    EXPECT_TRUE(s.insert(12));
+    EXPECT_TRUE(s.contains(12));
+}
+
+TEST(ConcurrentPackedSet, RacingInsertsOfSameValuesLandOnce) {
+    constexpr int kThreads = 8;
+    constexpr uint64_t kValues = 60;
+    for (int round = 0; round < 20; ++round) {
+        ConcurrentPackedSet<11, 64> s;
+        std::atomic<int> wins[kValues + 1] = {};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                // Each thread walks the values from a different start.
+                for (uint64_t k = 0; k < kValues; ++k) {
+                    uint64_t v = (k + uint64_t(t) * 7) % kValues + 1;
+                    if (s.insert(v))
+                        ++wins[v];
+                }
+            });
+        }
+        for (auto &th : threads)
+            th.join();
+        for (uint64_t v = 1; v <= kValues; ++v) {
+            ASSERT_EQ(wins[v].load(), 1) << v;
+            ASSERT_TRUE(s.contains(v));
+        }
+        auto vals = committed_values(s);
+        std::sort(vals.begin(), vals.end());
+        ASSERT_EQ(vals.size(), kValues);
+        ASSERT_TRUE(std::adjacent_find(vals.begin(), vals.end()) ==
+                    vals.end());
+    }
+}
+
+TEST(ConcurrentPackedSet, InsertEraseChurnStaysConsistent) {
+    // Threads insert and erase a shared pool of values. Per value, the
+    // successful inserts minus successful erases must equal its final
+    // presence, and no value may end up stored twice.
+    constexpr int kThreads = 6;
+    constexpr uint64_t kPool = 24;
+    ConcurrentPackedSet<11, 20> s;
+    std::atomic<int> balance[kPool + 1] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t));
+            for (int step = 0; step < 20000; ++step) {
+                uint64_t v = rng() % kPool + 1;
+                if (rng() % 2) {
+                    if (s.insert(v))
+                        ++balance[v];
+                } else {
+                    if (s.erase(v))
+                        --balance[v];
+                }
+                (void)s.contains(v);
+            }
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+    auto vals = committed_values(s);
+    std::sort(vals.begin(), vals.end());
+    EXPECT_TRUE(std::adjacent_find(vals.begin(), vals.end()) == vals.end());
+    for (uint64_t v = 1; v <= kPool; ++v) {
+        int present = std::binary_search(vals.begin(), vals.end(), v);
+        EXPECT_EQ(balance[v].load(), present) << v;
+        EXPECT_EQ(s.contains(v), present == 1) << v;
+    }
+}
+
+// ============================================================
+// ConcurrentBucketedSet
+// ============================================================
+
+// Every committed value of s; fails on a pending lane.
+template <class Set>
+static std::vector<uint64_t> committed_bucket_values(const Set &s) {
+    constexpr uint64_t lane_mask = (uint64_t(1) << Set::stored_bits) - 1;
+    constexpr unsigned count_shift = Set::lane_bits * Set::lanes_per_bucket;
+    std::vector<uint64_t> out;
+    for (std::size_t p = 0; p < Set::partitions; ++p) {
+        for (std::size_t i = 0; i < Set::buckets_per_partition; ++i) {
+            uint64_t b = s.load_bucket(p, i);
+            unsigned cnt = static_cast<unsigned>(b >> count_shift);
+            for (unsigned k = 0; k < cnt; ++k) {
+                uint64_t lane = b >> (k * Set::lane_bits);
+                EXPECT_EQ((lane >> Set::stored_bits) & 1, 0u)
+                    << "pending lane left behind";
+                out.push_back((p << Set::stored_bits) | (lane & lane_mask));
+            }
+        }
+    }
+    return out;
+}
+
+TEST(ConcurrentBucketedSet, MatchesReferenceSingleThreaded) {
+    ConcurrentBucketedSet<9> s; // 3 buckets per partition
+    std::set<uint64_t> ref;
+    std::mt19937 rng(5);
+    // Straddles the partition split at 1024.
+    std::uniform_int_distribution<uint64_t> dist(1000, 1040);
+    for (int step = 0; step < 5000; ++step) {
+        auto v = static_cast<uint16_t>(dist(rng));
+        if (rng() % 2) {
+            bool fits = std::count_if(ref.begin(), ref.end(), [&](uint64_t r) {
+                            return (r >> 10) == (v >> 10u);
+                        }) < 9;
+            ASSERT_EQ(s.insert(v), fits && ref.insert(v).second) << v;
+        } else {
+            ASSERT_EQ(s.erase(v), ref.erase(v) == 1) << v;
+        }
+        ASSERT_EQ(s.contains(v), ref.count(v) == 1);
+    }
+    auto vals = committed_bucket_values(s);
+    std::sort(vals.begin(), vals.end());
+    EXPECT_EQ(vals, std::vector<uint64_t>(ref.begin(), ref.end()));
+}
+
+TEST(ConcurrentBucketedSet, EraseMovesLastLaneAndCountTogether) {
+    ConcurrentBucketedSet<3> s; // one bucket per partition
+    EXPECT_TRUE(s.insert(1024)); // stored as lane value 0
+    EXPECT_TRUE(s.insert(1025));
+    EXPECT_TRUE(s.insert(1026));
+    EXPECT_FALSE(s.insert(1027)); // partition 1 full
+    EXPECT_EQ(s.load_bucket(1, 0),
+              (uint64_t(3) << 33) | (uint64_t(2) << 22) | (uint64_t(1) << 11));
+    EXPECT_TRUE(s.erase(1024));
+    // Lane 2 moved into lane 0, count 3 -> 2, in one word.
+    EXPECT_EQ(s.load_bucket(1, 0), (uint64_t(2) << 33) | (uint64_t(1) << 11) |
+                                       uint64_t(2));
+    EXPECT_TRUE(s.erase(1025)); // last lane: nothing moves
+    EXPECT_EQ(s.load_bucket(1, 0), (uint64_t(1) << 33) | uint64_t(2));
+    EXPECT_FALSE(s.contains(1024));
+    EXPECT_TRUE(s.contains(1026));
+    EXPECT_FALSE(s.contains(2)); // other partition
+    EXPECT_EQ(s.load_bucket(0, 0), 0u);
+}
+
+TEST(ConcurrentBucketedSet, RacingInsertsOfSameValuesLandOnce) {
+    constexpr int kThreads = 8;
+    constexpr uint64_t kValues = 60;
+    constexpr uint64_t kBase = 1500; // all in partition 1
+    for (int round = 0; round < 20; ++round) {
+        ConcurrentBucketedSet<64> s;
+        std::atomic<int> wins[kValues] = {};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                for (uint64_t k = 0; k < kValues; ++k) {
+                    uint64_t i = (k + uint64_t(t) * 7) % kValues;
+                    if (s.insert(static_cast<uint16_t>(kBase + i)))
+                        ++wins[i];
+                }
+            });
+        }
+        for (auto &th : threads)
+            th.join();
+        for (uint64_t i = 0; i < kValues; ++i) {
+            ASSERT_EQ(wins[i].load(), 1) << kBase + i;
+            ASSERT_TRUE(s.contains(static_cast<uint16_t>(kBase + i)));
+        }
+        auto vals = committed_bucket_values(s);
+        std::sort(vals.begin(), vals.end());
+        ASSERT_EQ(vals.size(), kValues);
+        ASSERT_TRUE(std::adjacent_find(vals.begin(), vals.end()) ==
+                    vals.end());
+    }
+}
+
+TEST(ConcurrentBucketedSet, InsertEraseChurnStaysConsistent) {
+    // As for ConcurrentPackedSet, but every value shares one partition,
+    // so erases keep moving lanes (pending ones included) under inserts.
+    constexpr int kThreads = 6;
+    constexpr uint64_t kPool = 24;
+    constexpr uint64_t kBase = 1024;
+    ConcurrentBucketedSet<20> s;
+    std::atomic<int> balance[kPool] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t));
+            for (int step = 0; step < 20000; ++step) {
+                uint64_t i = rng() % kPool;
+                auto v = static_cast<uint16_t>(kBase + i);
+                if (rng() % 2) {
+                    if (s.insert(v))
+                        ++balance[i];
+                } else {
+                    if (s.erase(v))
+                        --balance[i];
+                }
+                (void)s.contains(v);
+            }
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+    auto vals = committed_bucket_values(s);
+    std::sort(vals.begin(), vals.end());
+    EXPECT_TRUE(std::adjacent_find(vals.begin(), vals.end()) == vals.end());
+    for (uint64_t i = 0; i < kPool; ++i) {
+        int present = std::binary_search(vals.begin(), vals.end(), kBase + i);
+        EXPECT_EQ(balance[i].load(), present) << kBase + i;
+        EXPECT_EQ(s.contains(static_cast<uint16_t>(kBase + i)), present == 1);
+    }
+}
+
+// ============================================================
+// ShardedPackedSet
+// ============================================================
+
+TEST(ShardedPackedSet, DefaultShardIsOneLineCoveringItsKeys) {
+    using S = ShardedPackedSet<>;
+    static_assert(S::shard_count == 1024);
+    static_assert(S::Shard::num_words == 8);
+    static_assert(S::shard_capacity == 64);
+    S s;
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&s.shard_at(1)) -
+                  reinterpret_cast<uintptr_t>(&s.shard_at(0)),
+              64u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&s.shard_at(0)) % 64, 0u);
+    // A whole shard's key range fits.
+    for (unsigned k = 64 * 5; k < 64 * 6; ++k)
+        EXPECT_TRUE(s.insert(static_cast<uint16_t>(k)));
+    EXPECT_EQ(s.count(), 64u);
+    EXPECT_TRUE(s.insert(0));
+    EXPECT_TRUE(s.insert(65535));
+    EXPECT_TRUE(s.contains(0));
+    EXPECT_TRUE(s.contains(65535));
+    EXPECT_FALSE(s.contains(1));
+}
+
+TEST(ShardedPackedSet, MatchesReference) {
+    ShardedPackedSet<> s;
+    std::set<uint16_t> ref;
+    std::mt19937 rng(7);
+    for (int step = 0; step < 20000; ++step) {
+        auto key = static_cast<uint16_t>(rng());
+        if (rng() % 3) {
+            ASSERT_EQ(s.insert(key), ref.insert(key).second) << key;
+        } else {
+            ASSERT_EQ(s.erase(key), ref.erase(key) == 1) << key;
+        }
+    }
+    std::vector<uint16_t> got;
+    s.for_each([&](uint16_t k) { got.push_back(k); });
+    std::sort(got.begin(), got.end());
+    EXPECT_EQ(got, std::vector<uint16_t>(ref.begin(), ref.end()));
+    EXPECT_EQ(s.count(), ref.size());
+}
+
+TEST(ShardedPackedSet, SmallShardsFill) {
+    using S = ShardedPackedSet<4>; // 12-bit low keys in 14-bit lanes
+    static_assert(S::shard_capacity == 32);
+    S s;
+    for (unsigned k = 0; k < 32; ++k)
+        EXPECT_TRUE(s.insert(static_cast<uint16_t>(0x3000 + k)));
+    EXPECT_FALSE(s.insert(0x3fff)); // same shard, full
+    EXPECT_TRUE(s.insert(0x4000));
+    EXPECT_TRUE(s.erase(0x3005));
+    EXPECT_TRUE(s.insert(0x3fff));
+}
+
+TEST(ShardedPackedSet, WritersPartitionShards) {
+    using S = ShardedPackedSet<>;
+    S s;
+    for (std::size_t writers : {1u, 3u, 7u, 1024u, 2000u}) {
+        std::size_t next = 0;
+        for (std::size_t t = 0; t < writers; ++t) {
+            auto w = s.writer(t, writers);
+            EXPECT_EQ(w.begin(), next);
+            EXPECT_LE(w.begin(), w.end());
+            next = w.end();
+        }
+        EXPECT_EQ(next, S::shard_count);
+    }
+}
+
+TEST(ShardedPackedSet, ParallelIngestMatchesSerial) {
+    std::vector<uint16_t> keys(50000);
+    std::mt19937 rng(11);
+    for (auto &k : keys)
+        k = static_cast<uint16_t>(rng() % 40000);
+    std::set<uint16_t> ref(keys.begin(), keys.end());
+
+    constexpr std::size_t kWriters = 5;
+    ShardedPackedSet<> s;
+    std::atomic<std::size_t> added{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kWriters; ++t) {
+        threads.emplace_back([&, t] {
+            auto w = s.writer(t, kWriters);
+            added += w.ingest(keys.data(), keys.size());
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+    EXPECT_EQ(added.load(), ref.size());
+    EXPECT_EQ(s.count(), ref.size());
+    for (uint16_t k : ref)
+        ASSERT_TRUE(s.contains(k)) << k;
+
+    auto w = s.writer(2, kWriters);
+    w.clear();
+    std::size_t kept = 0;
+    for (uint16_t k : ref)
+        kept += !w.owns(k);
+    EXPECT_EQ(s.count(), kept);
+}
+
+// ============================================================
+// bulk_build
+// ============================================================
+
+// Sorted values of set h of arena a.
+template <class Arena>
+static std::vector<uint64_t> arena_values(const Arena &a,
+                                          typename Arena::handle h) {
+    std::vector<uint64_t> out;
+    const auto *w = a.set_words(h);
+    for (std::size_t i = 0; i < Arena::words_per_set; ++i)
+        for (unsigned k = 0; k < Arena::lanes_per_word; ++k)
+            if (uint64_t v = w[i].get(k))
+                out.push_back(v);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+TEST(BulkBuild, MatchesPerPairInsert) {
+    using Arena = PackedSetArena<11, 12, true>;
+    constexpr std::size_t kEntities = 20000; // several tasks per worker
+    std::vector<EntityValue> pairs(200000);
+    std::mt19937 rng(13);
+    for (auto &p : pairs) {
+        // Skewed: low entities get most pairs and overflow their sets.
+        p.entity = static_cast<uint32_t>(rng() % (rng() % kEntities + 1));
+        p.value = static_cast<uint32_t>(rng() % 40 + 1);
+    }
+    Arena ref(kEntities);
+    std::size_t want_inserted = 0, want_dropped = 0;
+    for (const auto &p : pairs) {
+        if (ref.contains(p.entity, p.value))
+            continue;
+        ++(ref.insert(p.entity, p.value) ? want_inserted : want_dropped);
+    }
+    ASSERT_GT(want_dropped, 0u);
+
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+        Arena a(5); // stale contents must be overwritten
+        a.insert(3, 999);
+        auto stats = bulk_build(a, pairs.data(), pairs.size(), kEntities,
+                                threads);
+        ASSERT_EQ(a.set_count(), kEntities);
+        EXPECT_EQ(stats.inserted, want_inserted) << threads;
+        EXPECT_EQ(stats.dropped, want_dropped) << threads;
+        for (uint32_t e = 0; e < kEntities; ++e) {
+            for (std::size_t i = 0; i < Arena::words_per_set; ++i)
+                ASSERT_EQ(a.set_words(e)[i].raw(), ref.set_words(e)[i].raw())
+                    << "entity " << e << ", " << threads << " threads";
+        }
+    }
+}
+
+TEST(BulkBuild, MoreThreadsThanEntitiesAndEmptyInput) {
+    PackedSetArena<11, 5> a;
+    std::vector<EntityValue> pairs = {{2, 7}, {0, 1}, {2, 7}, {2, 3}};
+    auto stats = bulk_build(a, pairs.data(), pairs.size(), 3, 16);
+    EXPECT_EQ(stats.inserted, 3u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(arena_values(a, 0), std::vector<uint64_t>({1}));
+    EXPECT_TRUE(arena_values(a, 1).empty());
+    EXPECT_EQ(arena_values(a, 2), std::vector<uint64_t>({3, 7}));
+
+    stats = bulk_build(a, pairs.data(), 0, 4, 2);
+    EXPECT_EQ(stats.inserted, 0u);
+    EXPECT_EQ(a.set_count(), 4u);
+    for (uint32_t e = 0; e < 4; ++e)
+        EXPECT_TRUE(arena_values(a, e).empty());
+}
+
+// ============================================================
+// Batched lookups across sets
+// ============================================================
+
+template <class Set> static void check_batch_lookup(std::size_t sets) {
+    std::vector<Set> storage(sets);
+    std::mt19937 rng(17);
+    constexpr uint64_t kMax = std::min<uint64_t>(Set::Word::max_safe_value,
+                                                 3 * Set::capacity);
+    for (auto &s : storage) {
+        std::size_t fill = rng() % (Set::capacity + 1);
+        for (std::size_t j = 0; j < fill; ++j)
+            s.insert(rng() % kMax + 1);
+    }
+    for (std::size_t count : {0u, 1u, 5u, 16u, 17u, 1000u}) {
+        std::vector<const Set *> ptrs(count);
+        std::vector<uint64_t> values(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            ptrs[i] = &storage[rng() % sets];
+            values[i] = rng() % kMax + 1;
+        }
+        std::unique_ptr<bool[]> a(new bool[count + 1]);
+        std::unique_ptr<bool[]> b(new bool[count + 1]);
+        contains_batch(ptrs.data(), values.data(), count, a.get());
+        contains_batch_amac(ptrs.data(), values.data(), count, b.get());
+        for (std::size_t i = 0; i < count; ++i) {
+            bool want = ptrs[i]->contains(values[i]);
+            ASSERT_EQ(a[i], want) << i;
+            ASSERT_EQ(b[i], want) << i;
+        }
+    }
+}
+
+TEST(BatchLookup, OneLineSets) { check_batch_lookup<PackedSet<11, 12>>(300); }
+
+TEST(BatchLookup, MultiLineUnalignedSets) {
+    // 17 words: every set spans three lines at varying offsets.
+    check_batch_lookup<PackedSet<11, 85>>(300);
+}
+
+TEST(BatchLookup, OtherPolicies) {
+    check_batch_lookup<PackedSet<7, 40, ExactZero>>(100);
+    check_batch_lookup<PackedSet<11, 30, GuardedZero, EraseCompact>>(100);
+}
+
+TEST(BatchLookup, ArenaHandles) {
+    using Arena = PackedSetArena<11, 24>; // 5 words, unaligned stride
+    Arena arena(500);
+    std::mt19937 rng(19);
+    for (uint32_t h = 0; h < 500; ++h)
+        for (int j = 0; j < 20; ++j)
+            arena.insert(h, rng() % 60 + 1);
+    constexpr std::size_t kCount = 2000;
+    std::vector<uint32_t> handles(kCount);
+    std::vector<uint64_t> values(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        handles[i] = static_cast<uint32_t>(rng() % 500);
+        values[i] = rng() % 60 + 1;
+    }
+    std::unique_ptr<bool[]> a(new bool[kCount]), b(new bool[kCount]);
+    contains_batch(arena, handles.data(), values.data(), kCount, a.get());
+    contains_batch_amac(arena, handles.data(), values.data(), kCount,
+                        b.get());
+    for (std::size_t i = 0; i < kCount; ++i) {
+        bool want = arena.contains(handles[i], values[i]);
+        ASSERT_EQ(a[i], want) << i;
+        ASSERT_EQ(b[i], want) << i;
+    }
+}